@@ -0,0 +1,215 @@
+/**
+ * \file SyntheticScene.cpp
+ *
+ */
+
+#include "SyntheticScene.hpp"
+
+#include <mars_interfaces/sim/SensorManagerInterface.h>
+#include <mars_interfaces/sim/NodeManagerInterface.h>
+#include <envire_types/registration/TypeCreatorFactory.hpp>
+#include <configmaps/ConfigMap.hpp>
+
+#include <cmath>
+#include <random>
+#include <stdexcept>
+
+namespace mars
+{
+    namespace core
+    {
+        namespace bench
+        {
+            using namespace configmaps;
+
+            namespace
+            {
+                void addItem(envire::core::EnvireGraph *graph, const std::string &frame,
+                             const std::string &className, ConfigMap config)
+                {
+                    if(!config.hasKey("name"))
+                    {
+                        config["name"] = frame;
+                    }
+                    auto item = envire::types::TypeCreatorFactory::createItem(className, config);
+                    if(!item)
+                    {
+                        throw std::runtime_error("SyntheticScene: could not create item " + className);
+                    }
+                    graph->addItemToFrame(frame, item);
+                }
+
+                void addFrame(envire::core::EnvireGraph *graph, const std::string &parent,
+                              const std::string &frame, const base::Vector3d &position)
+                {
+                    envire::core::Transform tf;
+                    tf.setIdentity();
+                    tf.transform.translation = position;
+                    tf.time = base::Time::now();
+                    graph->addFrame(frame);
+                    graph->addTransform(parent, frame, tf);
+                }
+
+                ConfigMap vector(double x, double y, double z)
+                {
+                    ConfigMap map;
+                    map["x"] = x;
+                    map["y"] = y;
+                    map["z"] = z;
+                    return map;
+                }
+
+                void addBody(envire::core::EnvireGraph *graph, const std::string &frame,
+                             double mass, const ConfigMap &geometry, const std::string &geometryClass)
+                {
+                    addItem(graph, frame, "envire::types::Link", ConfigMap{});
+                    ConfigMap inertial;
+                    inertial["mass"] = mass;
+                    inertial["xx"] = 0.1*mass;
+                    inertial["yy"] = 0.1*mass;
+                    inertial["zz"] = 0.1*mass;
+                    addItem(graph, frame, "envire::types::Inertial", inertial);
+                    addItem(graph, frame, geometryClass, geometry);
+                }
+            }
+
+            SceneContents buildScene(interfaces::ControlCenter *control, const SceneConfig &config)
+            {
+                SceneContents contents;
+                addWorlds(control, config, &contents);
+                addRovers(control, config, config.rovers, &contents);
+                addLidars(control, config, &contents);
+                return contents;
+            }
+
+            void addWorlds(interfaces::ControlCenter *control, const SceneConfig &config,
+                           SceneContents *contents)
+            {
+                auto *graph = control->envireGraph_.get();
+                std::mt19937 random{config.seed};
+                std::uniform_real_distribution<double> field{-50.0, 50.0};
+
+                // bounded worlds are placed side by side with a gap
+                const double groundSize = 200.0;
+                const double worldSpacing = config.boundedGround ? groundSize + 50.0 : 0.0;
+                for(size_t w = 0; w < config.worlds; ++w)
+                {
+                    const std::string worldFrame = "bench_world" + std::to_string(w);
+                    addFrame(graph, SIM_CENTER_FRAME_NAME, worldFrame, base::Vector3d{w*worldSpacing, 0.0, 0.0});
+                    ConfigMap world;
+                    world["prefix"] = worldFrame;
+                    addItem(graph, worldFrame, "envire::types::World", world);
+                    contents->worldFrames.push_back(worldFrame);
+
+                    const std::string ground = worldFrame + "_ground";
+                    if(config.boundedGround)
+                    {
+                        // top face at z = 0 like the plane
+                        addFrame(graph, worldFrame, ground, base::Vector3d{0.0, 0.0, -0.5});
+                        addItem(graph, ground, "envire::types::Link", ConfigMap{});
+                        ConfigMap box;
+                        box["size"] = vector(groundSize, groundSize, 1.0);
+                        addItem(graph, ground, "envire::types::geometry::Box", box);
+                    }
+                    else
+                    {
+                        addFrame(graph, worldFrame, ground, base::Vector3d::Zero());
+                        addItem(graph, ground, "envire::types::Link", ConfigMap{});
+                        ConfigMap plane;
+                        plane["size"] = vector(groundSize, groundSize, 0.0);
+                        addItem(graph, ground, "envire::types::geometry::Plane", plane);
+                    }
+
+                    // links without inertial are static
+                    for(size_t s = 0; s < config.statics; ++s)
+                    {
+                        const std::string frame = worldFrame + "_static" + std::to_string(s);
+                        addFrame(graph, worldFrame, frame, base::Vector3d{field(random), field(random), 0.5});
+                        addItem(graph, frame, "envire::types::Link", ConfigMap{});
+                        ConfigMap box;
+                        box["size"] = vector(1.0, 1.0, 1.0);
+                        addItem(graph, frame, "envire::types::geometry::Box", box);
+                        contents->staticFrames.push_back(frame);
+                    }
+                }
+            }
+
+            void addRovers(interfaces::ControlCenter *control, const SceneConfig &config,
+                           size_t count, SceneContents *contents)
+            {
+                auto *graph = control->envireGraph_.get();
+                // rovers on a grid with a fixed number of columns, so rovers
+                // added later continue the grid, each rover is a body with
+                // a chain of jointed links
+                const size_t columns = 16;
+                const size_t first = contents->roverBodies.size();
+                for(size_t r = first; r < first + count; ++r)
+                {
+                    const std::string &worldFrame = contents->worldFrames[r % contents->worldFrames.size()];
+                    const std::string rover = "rover" + std::to_string(r);
+                    const base::Vector3d position{4.0*(r % columns), 4.0*(r / columns), 1.0};
+
+                    const std::string body = rover + "_body";
+                    addFrame(graph, worldFrame, body, position);
+                    ConfigMap box;
+                    box["size"] = vector(1.0, 0.6, 0.3);
+                    addBody(graph, body, 10.0, box, "envire::types::geometry::Box");
+                    contents->nodes.push_back(body);
+                    contents->roverBodies.push_back(body);
+
+                    std::string parent = body;
+                    for(size_t j = 0; j < config.joints; ++j)
+                    {
+                        const std::string link = rover + "_link" + std::to_string(j);
+                        const std::string joint = rover + "_revolute" + std::to_string(j);
+                        // the frame of a non fixed joint is named "<joint>_joint" and
+                        // sits between the links like the JointManager creates it
+                        const std::string jointFrame = joint + "_joint";
+                        addFrame(graph, parent, jointFrame, base::Vector3d{0.0, 0.0, -0.2});
+                        addFrame(graph, jointFrame, link, base::Vector3d::Zero());
+                        ConfigMap cylinder;
+                        cylinder["radius"] = 0.05;
+                        cylinder["length"] = 0.2;
+                        addBody(graph, link, 0.5, cylinder, "envire::types::geometry::Cylinder");
+
+                        ConfigMap revolute;
+                        revolute["axis"] = vector(0.0, 1.0, 0.0);
+                        revolute["limit"]["lower"] = -M_PI;
+                        revolute["limit"]["upper"] = M_PI;
+                        revolute["limit"]["effort"] = 100.0;
+                        revolute["limit"]["velocity"] = 10.0;
+                        revolute["name"] = joint;
+                        revolute["parent_link_name"] = parent;
+                        revolute["child_link_name"] = link;
+                        addItem(graph, jointFrame, "envire::types::joints::Revolute", revolute);
+                        contents->nodes.push_back(link);
+                        contents->joints.push_back(joint);
+                        parent = link;
+                    }
+                }
+            }
+
+            void addLidars(interfaces::ControlCenter *control, const SceneConfig &config,
+                           SceneContents *contents)
+            {
+                if(contents->roverBodies.empty())
+                {
+                    return;
+                }
+                for(size_t l = 0; l < config.lidars; ++l)
+                {
+                    ConfigMap lidar;
+                    lidar["type"] = "RotatingRaySensor";
+                    lidar["name"] = "bench_lidar" + std::to_string(contents->lidars.size());
+                    lidar["attached_node"] = control->nodes->getID(contents->roverBodies[l % contents->roverBodies.size()]);
+                    lidar["bands"] = config.lidarBands;
+                    lidar["lasers"] = config.lidarLasers;
+                    lidar["max_distance"] = 100.0;
+                    lidar["draw_rays"] = false;
+                    lidar["rate"] = 10;
+                    contents->lidars.push_back(control->sensors->createAndAddSensor(&lidar));
+                }
+            }
+        } // end of namespace bench
+    } // end of namespace core
+} // end of namespace mars
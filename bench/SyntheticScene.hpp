@@ -0,0 +1,79 @@
+/**
+ * \file SyntheticScene.hpp
+ * \brief Builds benchmark scenes directly in the envire graph.
+ *
+ */
+
+#pragma once
+
+#include <mars_interfaces/sim/ControlCenter.h>
+#include <envire_core/graph/EnvireGraph.hpp>
+
+#include <string>
+#include <vector>
+
+namespace mars
+{
+    namespace core
+    {
+        namespace bench
+        {
+            struct SceneConfig
+            {
+                size_t worlds = 1; ///< the rovers are distributed round robin over the worlds
+                size_t rovers = 4;
+                size_t joints = 6; ///< revolute joints per rover, each with its own link
+                size_t lidars = 1; ///< rotating ray sensors, attached round robin to the rovers
+                size_t statics = 100; ///< static boxes per world
+                /**
+                 * Replaces the ground plane of each world by a flat box and
+                 * places the worlds side by side, so every world is bounded
+                 * and the culling of worlds by their bounds takes effect.
+                 */
+                bool boundedGround = false;
+                int lidarBands = 16;
+                int lidarLasers = 32;
+                unsigned int seed = 42;
+            };
+
+            /**
+             * Names of the created elements, used to look up their ids.
+             */
+            struct SceneContents
+            {
+                std::vector<std::string> worldFrames;
+                std::vector<std::string> roverBodies;
+                std::vector<std::string> nodes; ///< the link frames of the rovers
+                std::vector<std::string> joints; ///< joint names, their frames carry the "_joint" suffix
+                std::vector<std::string> staticFrames;
+                std::vector<unsigned long> lidars;
+            };
+
+            /**
+             * Adds the worlds, rovers, static boxes and lidars of the config
+             * to the graph of the control center. The items are created with
+             * the envire_types TypeCreatorFactory, the same way the scene
+             * loaders create them, so the physics plugins pick them up as
+             * they would for a loaded scene. The layout only depends on the
+             * config and its seed.
+             */
+            SceneContents buildScene(interfaces::ControlCenter *control, const SceneConfig &config);
+
+            /** Adds the worlds with their ground and static boxes. */
+            void addWorlds(interfaces::ControlCenter *control, const SceneConfig &config,
+                           SceneContents *contents);
+
+            /**
+             * Adds count rovers to the worlds of contents, continuing the
+             * numbering and the grid of the rovers added before. Allows to
+             * grow a scene step by step.
+             */
+            void addRovers(interfaces::ControlCenter *control, const SceneConfig &config,
+                           size_t count, SceneContents *contents);
+
+            /** Adds the lidars of the config to the rovers of contents. */
+            void addLidars(interfaces::ControlCenter *control, const SceneConfig &config,
+                           SceneContents *contents);
+        } // end of namespace bench
+    } // end of namespace core
+} // end of namespace mars
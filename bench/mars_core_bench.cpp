@@ -0,0 +1,193 @@
+/**
+ * \file mars_core_bench.cpp
+ * \brief Headless benchmark of the simulation step on synthetic scenes.
+ *
+ * Builds a scene from the command line parameters, runs a number of
+ * steps and reports the step rate, the step profile of the Simulator,
+ * the memory usage and the cost of frequently used accessors.
+ *
+ *   mars_core_bench [--worlds W] [--rovers N] [--joints M] [--lidars K]
+ *                   [--statics S] [--steps T] [--warmup U] [--seed X]
+ *                   [--ground plane|box] [--profile file]
+ *
+ * With "--ground box" every world stands on a flat box instead of an
+ * infinite plane and the worlds are placed side by side, so ray queries
+ * and the collision broadphase can cull worlds by their bounds.
+ */
+
+#include "SyntheticScene.hpp"
+#include "Simulator.hpp"
+#include "StepProfiler.hpp"
+#include "JointManager.hpp"
+
+#include <lib_manager/LibManager.hpp>
+#include <mars_interfaces/sim/NodeManagerInterface.h>
+
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace mars;
+using namespace mars::core;
+
+namespace
+{
+    // peak resident set size in MiB
+    double peakMemory()
+    {
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        return usage.ru_maxrss / 1024.0;
+    }
+
+    // runs the function count times and returns the mean time per call in ns
+    template <typename F>
+    double timeCalls(size_t count, F function)
+    {
+        const uint64_t start = StepProfiler::now();
+        for(size_t i = 0; i < count; ++i)
+        {
+            function(i);
+        }
+        return count ? static_cast<double>(StepProfiler::now() - start) / count : 0.0;
+    }
+
+    void usage(const char *name)
+    {
+        fprintf(stderr, "usage: %s [--worlds W] [--rovers N] [--joints M] [--lidars K] "
+                "[--statics S] [--steps T] [--warmup U] [--seed X] [--ground plane|box] "
+                "[--profile file]\n", name);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    bench::SceneConfig scene;
+    size_t steps = 1000, warmup = 100;
+    std::string profileFile;
+
+    for(int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        if(i + 1 >= argc)
+        {
+            usage(argv[0]);
+            return 1;
+        }
+        const char *value = argv[++i];
+        if(arg == "--worlds") scene.worlds = std::max(1, atoi(value));
+        else if(arg == "--rovers") scene.rovers = atoi(value);
+        else if(arg == "--joints") scene.joints = atoi(value);
+        else if(arg == "--lidars") scene.lidars = atoi(value);
+        else if(arg == "--statics") scene.statics = atoi(value);
+        else if(arg == "--steps") steps = atoi(value);
+        else if(arg == "--warmup") warmup = atoi(value);
+        else if(arg == "--seed") scene.seed = atoi(value);
+        else if(arg == "--ground" && std::string{value} == "plane") scene.boundedGround = false;
+        else if(arg == "--ground" && std::string{value} == "box") scene.boundedGround = true;
+        else if(arg == "--profile") profileFile = value;
+        else
+        {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    const double baseMemory = peakMemory();
+
+    // the libraries the simulator expects, no graphics and no gui
+    lib_manager::LibManager *libManager = new lib_manager::LibManager{};
+    libManager->loadLibrary("data_broker");
+    libManager->loadLibrary("cfg_manager");
+    libManager->loadLibrary("mars_ode_physics");
+    libManager->loadLibrary("mars_ode_collision");
+    auto *simulator = new Simulator{libManager};
+    libManager->addLibrary(simulator);
+    auto *control = simulator->getControlCenter();
+    auto *jointManager = dynamic_cast<JointManager*>(control->joints.get());
+
+    uint64_t time = StepProfiler::now();
+    const auto contents = bench::buildScene(control, scene);
+    const double buildTime = (StepProfiler::now() - time) * 1e-6;
+    const double sceneMemory = peakMemory();
+
+    simulator->runSimulation(false);
+    for(size_t i = 0; i < warmup; ++i)
+    {
+        simulator->step();
+    }
+    simulator->resetStepProfile();
+
+    time = StepProfiler::now();
+    for(size_t i = 0; i < steps; ++i)
+    {
+        simulator->step();
+    }
+    const double stepTime = (StepProfiler::now() - time) * 1e-9;
+
+    printf("scene: %lu worlds, %lu rovers, %lu joints each, %lu lidars, %lu statics per world, %s ground, seed %u\n",
+           scene.worlds, scene.rovers, scene.joints, scene.lidars, scene.statics,
+           scene.boundedGround ? "box" : "plane", scene.seed);
+    printf("build: %.1f ms\n", buildTime);
+    printf("steps: %lu in %.3f s, %.1f steps/s\n", steps, stepTime, stepTime > 0 ? steps / stepTime : 0.0);
+    printf("memory: %.1f MiB peak, %.1f MiB for the scene\n", peakMemory(), sceneMemory - baseMemory);
+
+    printf("\n%-40s %10s %10s %10s %10s %10s\n", "phase", "count", "mean_us", "p50_us", "p99_us", "max_us");
+    for(const auto &phase: simulator->getStepProfile())
+    {
+        printf("%-40s %10lu %10.2f %10.2f %10.2f %10.2f\n", phase.name.c_str(),
+               static_cast<unsigned long>(phase.count), phase.mean*1e-3,
+               phase.p50*1e-3, phase.p99*1e-3, phase.max*1e-3);
+    }
+    if(!profileFile.empty())
+    {
+        simulator->writeStepProfile(profileFile);
+    }
+
+    // accessors used by plugins and sensors in every step
+    const size_t calls = 100000;
+    std::vector<unsigned long> jointIds, nodeIds;
+    for(const auto &name: contents.joints)
+    {
+        jointIds.push_back(jointManager->getID(name));
+    }
+    for(const auto &name: contents.nodes)
+    {
+        nodeIds.push_back(control->nodes->getID(name));
+    }
+    printf("\n%-40s %10s\n", "accessor", "mean_ns");
+    if(!jointIds.empty())
+    {
+        const double t = timeCalls(calls, [&](size_t i) { jointManager->getJointInterface(jointIds[i % jointIds.size()]); });
+        printf("%-40s %10.1f\n", "JointManager::getJointInterface", t);
+    }
+    if(!nodeIds.empty())
+    {
+        volatile double sink = 0.0;
+        const double t = timeCalls(calls, [&](size_t i) { sink = control->nodes->getPosition(nodeIds[i % nodeIds.size()]).x(); });
+        printf("%-40s %10.1f\n", "NodeManager::getPosition", t);
+    }
+    {
+        std::mt19937 random{scene.seed};
+        std::uniform_real_distribution<double> angle{-M_PI, M_PI};
+        std::vector<utils::Vector> rays(1024);
+        for(auto &ray: rays)
+        {
+            const double a = angle(random);
+            ray = 50.0*utils::Vector{std::cos(a), std::sin(a), -0.1};
+        }
+        const utils::Vector origin{0.0, 0.0, 1.5};
+        const double t = timeCalls(calls/10, [&](size_t i) { simulator->getVectorCollision(origin, rays[i % rays.size()]); });
+        printf("%-40s %10.1f\n", "Simulator::getVectorCollision", t);
+    }
+
+    libManager->releaseLibrary("mars_core");
+    delete libManager;
+    return 0;
+}
@@ -0,0 +1,212 @@
+/**
+ * \file mars_core_microbench.cpp
+ * \brief Cost of manager lookups and graph traversals over the graph size.
+ *
+ * Grows a synthetic scene rover by rover and measures each call at every
+ * requested size. The output is one CSV line per call and size, so the
+ * cost can be plotted against the number of frames and joints:
+ *
+ *   benchmark,rovers,frames,joints,ns_per_call
+ *
+ *   mars_core_microbench [--sizes 1,2,4,...] [--joints M] [--worlds W]
+ *                        [--min-time ms]
+ */
+
+#include "SyntheticScene.hpp"
+#include "Simulator.hpp"
+#include "StepProfiler.hpp"
+#include "JointManager.hpp"
+#include "PosePropagator.hpp"
+
+#include <lib_manager/LibManager.hpp>
+#include <mars_interfaces/sim/NodeManagerInterface.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace mars;
+using namespace mars::core;
+
+namespace
+{
+    using VertexDesc = envire::core::GraphTraits::vertex_descriptor;
+
+    uint64_t minTime = 20000000; // ns per measurement
+
+    // Repeats the function, cycling through count arguments, until minTime
+    // has passed and returns the mean time per call in ns.
+    template <typename F>
+    double measure(size_t count, F function)
+    {
+        if(count == 0)
+        {
+            return 0.0;
+        }
+        size_t calls = 0;
+        const uint64_t start = StepProfiler::now();
+        uint64_t elapsed = 0;
+        do
+        {
+            for(size_t i = 0; i < count; ++i)
+            {
+                function(i);
+            }
+            calls += count;
+            elapsed = StepProfiler::now() - start;
+        } while(elapsed < minTime);
+        return static_cast<double>(elapsed) / calls;
+    }
+
+    // Times a single call in ns, for operations too expensive to repeat.
+    template <typename F>
+    double measureOnce(F function)
+    {
+        const uint64_t start = StepProfiler::now();
+        function();
+        return static_cast<double>(StepProfiler::now() - start);
+    }
+
+    std::vector<size_t> parseSizes(const std::string &list)
+    {
+        std::vector<size_t> sizes;
+        std::stringstream stream{list};
+        std::string item;
+        while(std::getline(stream, item, ','))
+        {
+            sizes.push_back(atoi(item.c_str()));
+        }
+        return sizes;
+    }
+
+    void usage(const char *name)
+    {
+        fprintf(stderr, "usage: %s [--sizes 1,2,4,...] [--joints M] [--worlds W] [--min-time ms]\n", name);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    bench::SceneConfig scene;
+    scene.statics = 0;
+    scene.lidars = 0;
+    std::vector<size_t> sizes{1, 2, 4, 8, 16, 32, 64};
+
+    for(int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        if(i + 1 >= argc)
+        {
+            usage(argv[0]);
+            return 1;
+        }
+        const char *value = argv[++i];
+        if(arg == "--sizes") sizes = parseSizes(value);
+        else if(arg == "--joints") scene.joints = atoi(value);
+        else if(arg == "--worlds") scene.worlds = std::max(1, atoi(value));
+        else if(arg == "--min-time") minTime = atoi(value) * 1000000ull;
+        else
+        {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    lib_manager::LibManager *libManager = new lib_manager::LibManager{};
+    libManager->loadLibrary("data_broker");
+    libManager->loadLibrary("cfg_manager");
+    libManager->loadLibrary("mars_ode_physics");
+    libManager->loadLibrary("mars_ode_collision");
+    auto *simulator = new Simulator{libManager};
+    libManager->addLibrary(simulator);
+    auto *control = simulator->getControlCenter();
+    auto *jointManager = dynamic_cast<JointManager*>(control->joints.get());
+    auto graph = control->envireGraph_;
+    auto treeView = control->graphTreeView_;
+    const VertexDesc rootVertex = graph->getVertex(SIM_CENTER_FRAME_NAME);
+
+    bench::SceneContents contents;
+    bench::addWorlds(control, scene, &contents);
+    simulator->runSimulation(false);
+    // a propagator of its own on the simulator's graph, finishedDraw runs
+    // the same calls on the private one of the simulator
+    PosePropagator posePropagator{graph, treeView};
+
+    printf("benchmark,rovers,frames,joints,ns_per_call\n");
+    for(const size_t size: sizes)
+    {
+        if(size > contents.roverBodies.size())
+        {
+            bench::addRovers(control, scene, size - contents.roverBodies.size(), &contents);
+        }
+
+        size_t frames = 0;
+        treeView->visitDfs(rootVertex, [&frames](VertexDesc, VertexDesc) { ++frames; });
+        std::vector<unsigned long> jointIds, nodeIds;
+        for(const auto &name: contents.joints)
+        {
+            jointIds.push_back(jointManager->getID(name));
+        }
+        for(const auto &name: contents.nodes)
+        {
+            nodeIds.push_back(control->nodes->getID(name));
+        }
+        const auto report = [&](const char *name, double ns)
+        {
+            printf("%s,%lu,%lu,%lu,%.1f\n", name, contents.roverBodies.size(),
+                   frames, jointIds.size(), ns);
+            fflush(stdout);
+        };
+
+        report("JointManager::getJointInterface(id)",
+               measure(jointIds.size(), [&](size_t i) { jointManager->getJointInterface(jointIds[i]); }));
+        report("JointManager::getJointInterface(name)",
+               measure(contents.joints.size(), [&](size_t i) { jointManager->getJointInterface(contents.joints[i]); }));
+        report("JointManager::getIDsByNodeID",
+               measure(nodeIds.size(), [&](size_t i) { jointManager->getIDsByNodeID(nodeIds[i]); }));
+        // getJoints() is private, getSimJoints() is its only caller
+        report("JointManager::getSimJoints",
+               measure(1, [&](size_t) { jointManager->getSimJoints(); }));
+        // the public accessors of the private getDynamicObject/getAbsolutePose lookups
+        report("NodeManager::getLinearVelocity",
+               measure(nodeIds.size(), [&](size_t i) { control->nodes->getLinearVelocity(nodeIds[i]); }));
+        report("NodeManager::getPosition",
+               measure(nodeIds.size(), [&](size_t i) { control->nodes->getPosition(nodeIds[i]); }));
+
+        // setupContactVector is measured through the handleContacts phase of the step
+        simulator->resetStepProfile();
+        measure(1, [&](size_t) { simulator->step(); });
+        for(const auto &phase: simulator->getStepProfile())
+        {
+            if(phase.name == "handleContacts")
+            {
+                report("CollisionManager::handleContacts", phase.mean);
+            }
+        }
+
+        // no physics thread runs, so the calls need no physics lock here
+        posePropagator.updatePlan();
+        report("PosePropagator::update(all)",
+               measure(1, [&](size_t)
+                       {
+                           posePropagator.invalidate();
+                           posePropagator.update();
+                       }));
+        report("PosePropagator::update(unchanged)",
+               measure(1, [&](size_t) { posePropagator.update(); }));
+        report("Simulator::rotateRevolute",
+               measure(contents.joints.size(), [&](size_t i) { Simulator::rotateRevolute(contents.joints[i], 0.0, graph, treeView); }));
+        // resetPoses() is private, the reload triggered by resetSim() runs it.
+        // The reload recreates the objects with new ids, so it is timed once
+        // and last, the next size resolves the ids from the names again.
+        report("Simulator::resetSim",
+               measureOnce([&]() { simulator->resetSim(false); simulator->finishedDraw(); }));
+    }
+
+    libManager->releaseLibrary("mars_core");
+    delete libManager;
+    return 0;
+}
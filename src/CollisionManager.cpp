@@ -10,33 +10,84 @@
 #include <envire_core/events/GraphEventPublisher.hpp>
 #include <mars_interfaces/sim/ControlCenter.h>
 #include "JointManager.hpp"
+#include "ThreadPool.hpp"
+
+#include <algorithm>
 
 
 namespace mars
 {
     namespace core
     {
-        CollisionManager::CollisionManager(const std::shared_ptr<interfaces::ControlCenter>& controlCenter) : controlCenter_{controlCenter.get()}
+        CollisionManager::CollisionManager(const std::shared_ptr<interfaces::ControlCenter>& controlCenter) : controlCenter_{controlCenter.get()}, threadPool{nullptr},
+            numContactBatches{0}, concurrentRayQueries{false}, numPlugins{0}, useBroadphase{false},
+            contactPluginIndexOutdated{true}
         {
             envire::core::GraphItemEventDispatcher<envire::core::Item<interfaces::ContactPluginInterfaceItem>>::subscribe(controlCenter_->envireGraph_.get());
             envire::core::GraphItemEventDispatcher<envire::core::Item<interfaces::CollisionInterfaceItem>>::subscribe(controlCenter_->envireGraph_.get());
+            envire::core::GraphItemEventDispatcher<envire::core::Item<interfaces::DynamicObjectItem>>::subscribe(controlCenter_->envireGraph_.get());
+            envire::core::GraphItemEventDispatcher<envire::core::Item<ContactPluginScope>>::subscribe(controlCenter_->envireGraph_.get());
         }
 
         CollisionManager::~CollisionManager()
         {
             envire::core::GraphItemEventDispatcher<envire::core::Item<interfaces::ContactPluginInterfaceItem>>::unsubscribe();
             envire::core::GraphItemEventDispatcher<envire::core::Item<interfaces::CollisionInterfaceItem>>::unsubscribe();
+            envire::core::GraphItemEventDispatcher<envire::core::Item<interfaces::DynamicObjectItem>>::unsubscribe();
+            envire::core::GraphItemEventDispatcher<envire::core::Item<ContactPluginScope>>::unsubscribe();
         }
 
         void CollisionManager::addCollisionHandler(const std::string &name1, const std::string &name2,
-                                                   std::shared_ptr<interfaces::CollisionHandler> collisionHandler)
+                                                   std::shared_ptr<interfaces::CollisionHandler> collisionHandler,
+                                                   bool concurrent)
         {
             if (collisionHandlers.count(std::make_pair(name2, name1)) > 0)
             {
                 const auto msg = std::string{"CollisionManager::addCollisionManager: Adding collision handler for (\""} + name1 + "\", \"" + name2 + "\") but there is already one for the inverse tuple.";
                 LOG_WARN(msg.c_str());
             }
-            collisionHandlers[std::make_pair(name1, name2)] =  collisionHandler;
+            collisionHandlers[std::make_pair(name1, name2)] = RegisteredHandler{collisionHandler, concurrent};
+            updateCollisionPairs();
+        }
+
+        void CollisionManager::setThreadPool(ThreadPool *threadPool)
+        {
+            this->threadPool = threadPool;
+        }
+
+        void CollisionManager::setConcurrentRayQueries(const std::string &pluginName, bool concurrent)
+        {
+            if(concurrent)
+            {
+                concurrentRayPlugins.insert(pluginName);
+            }
+            else
+            {
+                concurrentRayPlugins.erase(pluginName);
+            }
+            updateCollisionPairs();
+        }
+
+        bool CollisionManager::allowsConcurrentRayQueries() const
+        {
+            return concurrentRayQueries;
+        }
+
+        void CollisionManager::setBroadphase(bool enabled)
+        {
+            useBroadphase = enabled;
+            updateCollisionPairs();
+        }
+
+        void CollisionManager::setBounds(const interfaces::CollisionInterface *collisionInterface,
+                                         const WorldBounds &bounds)
+        {
+            const auto it = itemIndices.find(collisionInterface);
+            if(it == itemIndices.end())
+            {
+                return;
+            }
+            broadphase.setBounds(it->second, bounds);
         }
 
         std::vector<interfaces::ContactData>& CollisionManager::getContactVector()
@@ -99,6 +150,7 @@ namespace mars
             auto removeFunctor = [&graph](VertexType node, VertexType parent)
             {
                 itemRemover<interfaces::ContactPluginInterfaceItem>(graph, node);
+                itemRemover<ContactPluginScope>(graph, node);
             };
 
             const auto& rootVertex = controlCenter_->envireGraph_->getVertex(SIM_CENTER_FRAME_NAME);
@@ -111,6 +163,8 @@ namespace mars
             auto& item = event.item->getData();
             item.contactPluginInterface->setFrameID(event.frame);
             contactPlugins.push_back(item.contactPluginInterface.get());
+            contactPluginFrames.push_back(event.frame);
+            contactPluginIndexOutdated = true;
         }
 
         void CollisionManager::itemRemoved(const envire::core::TypedItemRemovedEvent<envire::core::Item<interfaces::ContactPluginInterfaceItem>>& event)
@@ -122,13 +176,40 @@ namespace mars
                     return x == item;
                 });
             assert(positionOfItem != std::end(contactPlugins));
+            contactPluginFrames.erase(contactPluginFrames.begin() + (positionOfItem - contactPlugins.begin()));
             contactPlugins.erase(positionOfItem);
+            contactPluginIndexOutdated = true;
+        }
+
+        void CollisionManager::itemAdded(const envire::core::TypedItemAddedEvent<envire::core::Item<interfaces::DynamicObjectItem>>& event)
+        {
+            // the index refers to the dynamic objects of the scoped frames
+            contactPluginIndexOutdated = true;
+        }
+
+        void CollisionManager::itemRemoved(const envire::core::TypedItemRemovedEvent<envire::core::Item<interfaces::DynamicObjectItem>>& event)
+        {
+            contactPluginIndexOutdated = true;
+        }
+
+        void CollisionManager::itemAdded(const envire::core::TypedItemAddedEvent<envire::core::Item<ContactPluginScope>>& event)
+        {
+            // a later scope in the same frame replaces the earlier one
+            contactPluginScopes[event.frame] = event.item->getData();
+            contactPluginIndexOutdated = true;
+        }
+
+        void CollisionManager::itemRemoved(const envire::core::TypedItemRemovedEvent<envire::core::Item<ContactPluginScope>>& event)
+        {
+            contactPluginScopes.erase(event.frame);
+            contactPluginIndexOutdated = true;
         }
 
         void CollisionManager::itemAdded(const envire::core::TypedItemAddedEvent<envire::core::Item<interfaces::CollisionInterfaceItem>>& event)
         {
             auto& item = event.item->getData();
             collisionItems.push_back(item);
+            updateCollisionPairs();
         }
 
         void CollisionManager::itemRemoved(const envire::core::TypedItemRemovedEvent<envire::core::Item<interfaces::CollisionInterfaceItem>>& event)
@@ -136,6 +217,94 @@ namespace mars
             auto& item = event.item->getData();
             auto positionOfItem = std::find(std::begin(collisionItems), std::end(collisionItems), item);
             collisionItems.erase(positionOfItem);
+            updateCollisionPairs();
+        }
+
+        void CollisionManager::updateCollisionPairs()
+        {
+            // resolves the handlers by plugin index once, so the step
+            // compares no names
+            std::map<std::string, size_t> plugins;
+            pluginIndices.clear();
+            itemIndices.clear();
+            for(size_t l=0; l<collisionItems.size(); ++l)
+            {
+                pluginIndices.push_back(plugins.emplace(collisionItems[l].pluginName, plugins.size()).first->second);
+                itemIndices[collisionItems[l].collisionInterface.get()] = l;
+            }
+            numPlugins = plugins.size();
+            bool concurrentRays = !collisionItems.empty();
+            for(const auto& plugin: plugins)
+            {
+                concurrentRays = concurrentRays && concurrentRayPlugins.count(plugin.first) > 0;
+            }
+            concurrentRayQueries = concurrentRays;
+            handlerTable.assign(numPlugins*numPlugins, HandlerEntry{nullptr, false, false});
+            for(const auto& plugin1: plugins)
+            {
+                for(const auto& plugin2: plugins)
+                {
+                    auto& entry = handlerTable[plugin1.second*numPlugins + plugin2.second];
+                    auto handlerIt = collisionHandlers.find(std::make_pair(plugin1.first, plugin2.first));
+                    if(handlerIt != collisionHandlers.end())
+                    {
+                        entry = HandlerEntry{handlerIt->second.handler.get(), false, handlerIt->second.concurrent};
+                        continue;
+                    }
+                    handlerIt = collisionHandlers.find(std::make_pair(plugin2.first, plugin1.first));
+                    if(handlerIt != collisionHandlers.end())
+                    {
+                        entry = HandlerEntry{handlerIt->second.handler.get(), true, handlerIt->second.concurrent};
+                    }
+                }
+            }
+
+            // items are unbounded until their bounds are set
+            broadphase.resize(collisionItems.size());
+
+            // the broadphase selects the pairs in each step
+            collisionPairs.clear();
+            if(useBroadphase)
+            {
+                return;
+            }
+            for(size_t l=0; l<collisionItems.size(); ++l)
+            {
+                for(size_t k=l+1; k<collisionItems.size(); ++k)
+                {
+                    addCollisionPair(l, k);
+                }
+            }
+        }
+
+        void CollisionManager::addCollisionPair(size_t l, size_t k)
+        {
+            const auto& entry = handlerTable[pluginIndices[l]*numPlugins + pluginIndices[k]];
+            if(!entry.handler)
+            {
+                return;
+            }
+            const auto& ci1 = collisionItems[l].collisionInterface;
+            const auto& ci2 = collisionItems[k].collisionInterface;
+            if(entry.swapped)
+            {
+                collisionPairs.push_back(CollisionPair{ci2, ci1, entry.handler, entry.concurrent, {k, l}});
+            }
+            else
+            {
+                collisionPairs.push_back(CollisionPair{ci1, ci2, entry.handler, entry.concurrent, {l, k}});
+            }
+        }
+
+        void CollisionManager::findOverlappingPairs()
+        {
+            // same pair order as without the broadphase
+            broadphase.findOverlappingPairs(&overlappingPairs);
+            collisionPairs.clear();
+            for(const auto& pair: overlappingPairs)
+            {
+                addCollisionPair(pair.first, pair.second);
+            }
         }
 
         void CollisionManager::setupContactVector()
@@ -146,50 +315,187 @@ namespace mars
             // TODO: for future:
             // - where to load spaces? from envire_graph?
             // - how to deal with sub-collision-spaces?
-            // - first check bounding boxes // collect boxes of sub-spaces
-            decltype(collisionHandlers)::iterator handlerIt;
-            for(size_t l=0; l<collisionItems.size(); ++l)
+            if(useBroadphase)
             {
-                for(size_t k=l+1; k<collisionItems.size(); ++k)
+                findOverlappingPairs();
+            }
+            if(!threadPool || collisionPairs.size() < 2)
+            {
+                for(const auto& pair: collisionPairs)
                 {
-                    const auto& ci1 = collisionItems[l].collisionInterface;
-                    const auto& ci2 = collisionItems[k].collisionInterface;
-                    const auto& ci1PluginName = collisionItems[l].pluginName;
-                    const auto& ci2PluginName = collisionItems[k].pluginName;
-                    handlerIt = collisionHandlers.find(std::make_pair(ci1PluginName,
-                                                                      ci2PluginName));
-                    if(handlerIt != collisionHandlers.end())
+                    // extends contacts
+                    pair.handler->getContacts(pair.first, pair.second, contactVector);
+                }
+                return;
+            }
+
+            // the buffers keep their capacity between the steps
+            scheduleContactBatches();
+            pairContacts.resize(collisionPairs.size());
+            for(size_t b=0; b<numContactBatches; ++b)
+            {
+                const auto& batch = contactBatches[b];
+                threadPool->parallelFor(batch.size(), [this, &batch](size_t i)
+                {
+                    const auto& pair = collisionPairs[batch[i]];
+                    auto& contacts = pairContacts[batch[i]];
+                    contacts.clear();
+                    pair.handler->getContacts(pair.first, pair.second, contacts);
+                });
+            }
+            size_t numContacts = 0;
+            for(const auto& contacts: pairContacts)
+            {
+                numContacts += contacts.size();
+            }
+            contactVector.reserve(numContacts);
+            for(const auto& contacts: pairContacts)
+            {
+                contactVector.insert(contactVector.end(), contacts.begin(), contacts.end());
+            }
+        }
+
+        void CollisionManager::scheduleContactBatches()
+        {
+            // the first batch takes the pairs of concurrent handlers, the
+            // others are placed into the first batch after it that uses
+            // neither of their items, so the pairs sharing an item run one
+            // after another
+            const size_t numItems = collisionItems.size();
+            numContactBatches = 1;
+            for(size_t b=0; b<contactBatches.size(); ++b)
+            {
+                contactBatches[b].clear();
+                batchItems[b].assign(numItems, 0);
+            }
+            if(contactBatches.empty())
+            {
+                contactBatches.emplace_back();
+                batchItems.emplace_back(numItems, 0);
+            }
+            for(size_t i=0; i<collisionPairs.size(); ++i)
+            {
+                const auto& pair = collisionPairs[i];
+                if(pair.concurrent)
+                {
+                    contactBatches[0].push_back(i);
+                    continue;
+                }
+                size_t b = 1;
+                while(b < numContactBatches &&
+                      (batchItems[b][pair.items[0]] || batchItems[b][pair.items[1]]))
+                {
+                    ++b;
+                }
+                if(b == numContactBatches)
+                {
+                    ++numContactBatches;
+                    if(contactBatches.size() < numContactBatches)
                     {
-                        // extends contacts
-                        handlerIt->second->getContacts(ci1, ci2, contactVector);
-                        continue;
+                        contactBatches.emplace_back();
+                        batchItems.emplace_back(numItems, 0);
                     }
+                }
+                contactBatches[b].push_back(i);
+                batchItems[b][pair.items[0]] = 1;
+                batchItems[b][pair.items[1]] = 1;
+            }
+        }
 
-                    handlerIt = collisionHandlers.find(std::make_pair(ci2PluginName,
-                                                                      ci1PluginName));
-                    if(handlerIt != collisionHandlers.end())
+        void CollisionManager::updateContactPluginIndex()
+        {
+            using DynamicObjectEnvireItem = envire::core::Item<interfaces::DynamicObjectItem>;
+            auto* const graph = controlCenter_->envireGraph_.get();
+            contactPluginIndexOutdated = false;
+            contactPluginIndex.clear();
+            globalContactPlugins.clear();
+            for(size_t order=0; order<contactPlugins.size(); ++order)
+            {
+                auto* const contactPlugin = contactPlugins[order];
+                const auto scope = contactPluginScopes.find(contactPluginFrames[order]);
+                if(scope == contactPluginScopes.end() || scope->second.frames.empty())
+                {
+                    const int priority = scope == contactPluginScopes.end() ? 0 : scope->second.priority;
+                    globalContactPlugins.push_back(IndexedContactPlugin{priority, order, contactPlugin});
+                    continue;
+                }
+                for(const auto& frame: scope->second.frames)
+                {
+                    if(!graph->containsFrame(frame) || !graph->containsItems<DynamicObjectEnvireItem>(frame))
                     {
-                        // extends contacts
-                        handlerIt->second->getContacts(ci2, ci1, contactVector);
                         continue;
                     }
+                    const auto* const dynamicObject = graph->getItem<DynamicObjectEnvireItem>(frame)->getData().dynamicObject.get();
+                    contactPluginIndex[dynamicObject].push_back(IndexedContactPlugin{scope->second.priority, order, contactPlugin});
                 }
             }
+            std::sort(globalContactPlugins.begin(), globalContactPlugins.end());
+            for(auto& plugins: contactPluginIndex)
+            {
+                std::sort(plugins.second.begin(), plugins.second.end());
+            }
         }
 
         void CollisionManager::applyContactPlugins()
         {
+            if(contactPlugins.empty())
+            {
+                return;
+            }
+            if(contactPluginIndexOutdated)
+            {
+                updateContactPluginIndex();
+            }
+
+            static const ContactPluginList noPlugins;
+            auto findPlugins = [this](const interfaces::DynamicObject *body) -> const ContactPluginList&
+            {
+                if(!body)
+                {
+                    return noPlugins;
+                }
+                const auto it = contactPluginIndex.find(body);
+                return it == contactPluginIndex.end() ? noPlugins : it->second;
+            };
+
             for (auto& contact : contactVector)
             {
-                for (const auto& contactPlugin : contactPlugins)
+                // the candidates of both bodies and the unscoped plugins, each
+                // sorted by priority, are merged until one affects the contact
+                const ContactPluginList* lists[3] = {&findPlugins(contact.body1.get()),
+                                                     &findPlugins(contact.body2.get()),
+                                                     &globalContactPlugins};
+                size_t cursors[3] = {0, 0, 0};
+                // a plugin scoped to both bodies is in two lists, the merge
+                // yields its entries one after another
+                const IndexedContactPlugin *last = nullptr;
+                while(true)
                 {
-                    if (!contactPlugin->affects(contact))
+                    int best = -1;
+                    for(int i=0; i<3; ++i)
+                    {
+                        if(cursors[i] < lists[i]->size() &&
+                           (best < 0 || (*lists[i])[cursors[i]] < (*lists[best])[cursors[best]]))
+                        {
+                            best = i;
+                        }
+                    }
+                    if(best < 0)
+                    {
+                        break;
+                    }
+                    const auto& candidate = (*lists[best])[cursors[best]++];
+                    if(last && last->order == candidate.order)
                     {
                         continue;
                     }
-
-                    contactPlugin->updateContact(contact);
-                    break; // TODO: Apply affecting contact plugin with highest priority.
+                    last = &candidate;
+                    auto* const contactPlugin = candidate.contactPlugin;
+                    if (contactPlugin->affects(contact))
+                    {
+                        contactPlugin->updateContact(contact);
+                        break;
+                    }
                 }
             }
         }
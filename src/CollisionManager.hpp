@@ -7,13 +7,22 @@
 
 #pragma once
 
+#include "ContactPluginScope.hpp"
+#include "SweepAndPrune.hpp"
+#include "WorldBounds.hpp"
+
+#include <atomic>
+#include <map>
 #include <memory>
+#include <set>
+#include <unordered_map>
 #include <vector>
 
 #include <mars_interfaces/sim/ControlCenter.h>
 #include <mars_interfaces/sim/CollisionInterface.hpp>
 #include <mars_interfaces/sim/CollisionHandler.hpp>
 #include <mars_interfaces/sim/ContactPluginInterface.hpp>
+#include <mars_interfaces/sim/DynamicObject.hpp>
 
 #include <envire_core/items/Item.hpp>
 #include <envire_core/events/GraphItemEventDispatcher.hpp>
@@ -22,37 +31,157 @@ namespace mars
 {
     namespace core
     {
+        class ThreadPool;
+
         class CollisionManager :    public envire::core::GraphItemEventDispatcher<envire::core::Item<interfaces::ContactPluginInterfaceItem>>,
-                                    public envire::core::GraphItemEventDispatcher<envire::core::Item<interfaces::CollisionInterfaceItem>>
+                                    public envire::core::GraphItemEventDispatcher<envire::core::Item<interfaces::CollisionInterfaceItem>>,
+                                    public envire::core::GraphItemEventDispatcher<envire::core::Item<interfaces::DynamicObjectItem>>,
+                                    public envire::core::GraphItemEventDispatcher<envire::core::Item<ContactPluginScope>>
         {
         public:
             CollisionManager(const std::shared_ptr<interfaces::ControlCenter>& controlCenter);
             virtual ~CollisionManager();
 
+            /**
+             * Registers the handler for the items of the collision plugins
+             * name1 and name2. Every handler has to allow concurrent
+             * getContacts() calls for pairs without a common collision
+             * interface. A concurrent handler also allows concurrent calls for
+             * pairs sharing an interface.
+             */
             void addCollisionHandler(const std::string &name1, const std::string &name2,
-                                     std::shared_ptr<interfaces::CollisionHandler> collisionHandler);
+                                     std::shared_ptr<interfaces::CollisionHandler> collisionHandler,
+                                     bool concurrent = false);
             void handleContacts();
             std::vector<interfaces::ContactData>& getContactVector();
             void updateTransforms();
             void clear();
             void clearPlugins();
             void reset();
+            /**
+             * Generates the contacts of the collision pairs in parallel on the
+             * given pool, nullptr generates them serially. The pairs are run in
+             * batches in which no two pairs share a collision interface,
+             * except for the pairs of concurrent handlers, which form one
+             * batch of their own. The contacts are merged in pair order, so
+             * the result does not depend on the number of threads. Must not
+             * be called while the contacts are generated.
+             */
+            void setThreadPool(ThreadPool *threadPool);
+
+            /**
+             * Declares whether the collision interfaces of the given plugin
+             * allow concurrent getVectorCollision() calls, also on the same
+             * interface. No plugin allows them by default.
+             */
+            void setConcurrentRayQueries(const std::string &pluginName, bool concurrent);
+            /**
+             * Returns true if the plugins of all collision items allow
+             * concurrent ray queries. Can be called from any thread.
+             */
+            bool allowsConcurrentRayQueries() const;
+
+            /**
+             * Enables the broadphase between the collision items. Only pairs
+             * with overlapping bounds are passed to the collision handlers.
+             * The overlaps are found by a SweepAndPrune over the items.
+             * Must not be called while the contacts are generated.
+             */
+            void setBroadphase(bool enabled);
+            /**
+             * Sets the bounds of the item with the given interface for the
+             * next contact generation. Items without bounds are unbounded.
+             */
+            void setBounds(const interfaces::CollisionInterface *collisionInterface,
+                           const WorldBounds &bounds);
 
         protected:
             virtual void itemAdded(const envire::core::TypedItemAddedEvent<envire::core::Item<interfaces::ContactPluginInterfaceItem>>& event) override;
             virtual void itemRemoved(const envire::core::TypedItemRemovedEvent<envire::core::Item<interfaces::ContactPluginInterfaceItem>>& event) override;
             virtual void itemAdded(const envire::core::TypedItemAddedEvent<envire::core::Item<interfaces::CollisionInterfaceItem>>& event) override;
             virtual void itemRemoved(const envire::core::TypedItemRemovedEvent<envire::core::Item<interfaces::CollisionInterfaceItem>>& event) override;
+            virtual void itemAdded(const envire::core::TypedItemAddedEvent<envire::core::Item<interfaces::DynamicObjectItem>>& event) override;
+            virtual void itemRemoved(const envire::core::TypedItemRemovedEvent<envire::core::Item<interfaces::DynamicObjectItem>>& event) override;
+            virtual void itemAdded(const envire::core::TypedItemAddedEvent<envire::core::Item<ContactPluginScope>>& event) override;
+            virtual void itemRemoved(const envire::core::TypedItemRemovedEvent<envire::core::Item<ContactPluginScope>>& event) override;
 
         private:
             void setupContactVector();
             void applyContactPlugins();
+            void updateCollisionPairs();
+            void addCollisionPair(size_t l, size_t k);
+            void findOverlappingPairs();
+            void scheduleContactBatches();
+            void updateContactPluginIndex();
+
+            // a pair of collision items with a handler, in the argument order of the handler
+            struct CollisionPair
+            {
+                std::shared_ptr<interfaces::CollisionInterface> first, second;
+                interfaces::CollisionHandler *handler;
+                bool concurrent;
+                size_t items[2]; ///< indices of the collision items
+            };
+
+            struct RegisteredHandler
+            {
+                std::shared_ptr<interfaces::CollisionHandler> handler;
+                bool concurrent;
+            };
+
+            // the handler for a pair of plugins
+            struct HandlerEntry
+            {
+                interfaces::CollisionHandler *handler;
+                bool swapped; ///< the handler expects the second item first
+                bool concurrent;
+            };
+
+            struct IndexedContactPlugin
+            {
+                int priority;
+                size_t order; ///< position in contactPlugins
+                interfaces::ContactPluginInterface *contactPlugin;
+
+                bool operator<(const IndexedContactPlugin &other) const
+                {
+                    return priority > other.priority || (priority == other.priority && order < other.order);
+                }
+            };
+            using ContactPluginList = std::vector<IndexedContactPlugin>;
 
             interfaces::ControlCenter* const controlCenter_;
-            std::map<std::pair<std::string, std::string>, std::shared_ptr<interfaces::CollisionHandler>> collisionHandlers;
+            std::map<std::pair<std::string, std::string>, RegisteredHandler> collisionHandlers;
             std::vector<interfaces::ContactData> contactVector;
             std::vector<interfaces::CollisionInterfaceItem> collisionItems;
             std::vector<interfaces::ContactPluginInterface*> contactPlugins;
+            std::vector<envire::core::FrameId> contactPluginFrames; ///< per plugin, the frame of its item
+            std::vector<CollisionPair> collisionPairs; ///< resolved when items or handlers change, per step with the broadphase
+            std::vector<std::vector<interfaces::ContactData>> pairContacts; ///< per pair buffers of the parallel generation
+            std::vector<std::vector<size_t>> contactBatches; ///< pair indices, the pairs of a batch run in parallel
+            std::vector<std::vector<char>> batchItems; ///< per batch, the collision items it uses
+            size_t numContactBatches;
+            std::set<std::string> concurrentRayPlugins;
+            std::atomic<bool> concurrentRayQueries; ///< resolved when items or plugins change
+            ThreadPool *threadPool;
+
+            // resolved when items or handlers change
+            std::vector<size_t> pluginIndices; ///< per item
+            size_t numPlugins;
+            std::vector<HandlerEntry> handlerTable; ///< numPlugins x numPlugins
+            std::unordered_map<const interfaces::CollisionInterface*, size_t> itemIndices;
+
+            // broadphase
+            bool useBroadphase;
+            SweepAndPrune broadphase; ///< over the collision items
+            std::vector<std::pair<size_t, size_t>> overlappingPairs;
+
+            // contact plugin dispatch, the index is rebuilt when plugins,
+            // scopes or dynamic objects change
+            std::map<envire::core::FrameId, ContactPluginScope> contactPluginScopes; ///< by the frame of the plugins
+            std::unordered_map<const interfaces::DynamicObject*, ContactPluginList> contactPluginIndex;
+            ContactPluginList globalContactPlugins;
+            std::atomic<bool> contactPluginIndexOutdated;
         };
     } // end of namespace core
 } // end of namespace mars
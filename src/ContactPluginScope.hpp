@@ -0,0 +1,32 @@
+/**
+ * \file ContactPluginScope.hpp
+ * \brief Restricts the contact plugins of a frame to the contacts of some bodies.
+ *
+ */
+
+#pragma once
+
+#include <envire_core/items/Item.hpp>
+
+#include <vector>
+
+namespace mars
+{
+    namespace core
+    {
+        /**
+         * Added as envire item to the frame of a ContactPluginInterfaceItem,
+         * the plugins of that frame are only asked for the contacts of the
+         * DynamicObjects in the given frames. Each contact is handed to the
+         * affecting plugin with the highest priority, plugins with equal
+         * priority in the order they were added. Plugins without scope or
+         * with empty frames are asked for every contact with their priority,
+         * 0 without scope.
+         */
+        struct ContactPluginScope
+        {
+            std::vector<envire::core::FrameId> frames;
+            int priority = 0;
+        };
+    } // end of namespace core
+} // end of namespace mars
@@ -1,15 +1,33 @@
 #pragma once
 
 #include <string>
+#include <vector>
 #include <mars_interfaces/sim/ControlCenter.h>
 #include <mars_interfaces/sim/IDManager.hpp>
+#include <mars_interfaces/sim/AbsolutePose.hpp>
+#include <mars_interfaces/sim/DynamicObject.hpp>
 #include <envire_core/events/GraphEventDispatcher.hpp>
 #include <envire_core/graph/EnvireGraph.hpp>
+#include <envire_core/graph/GraphTypes.hpp>
 
 namespace mars
 {
     namespace core
     {
+        /**
+         * Cached references into the frame of a node. The item pointers are
+         * updated by the graph events whenever a DynamicObjectItem or
+         * AbsolutePose is added to or removed from the frame, so reading a
+         * handle never writes to it.
+         */
+        struct FrameHandle
+        {
+            envire::core::GraphTraits::vertex_descriptor vertex;
+            interfaces::DynamicObject* dynamicObject = nullptr;
+            interfaces::AbsolutePose* absolutePose = nullptr;
+            bool known = false;
+        };
+
         class FrameIDManager :  public interfaces::IDManager,
                                 public envire::core::GraphEventDispatcher
         {
@@ -21,13 +39,105 @@ namespace mars
 
             virtual void frameAdded(const envire::core::FrameAddedEvent& e) override
             {
-                addIfUnknown(e.frame);
+                addFrame(e.frame);
             }
 
             virtual void frameRemoved(const envire::core::FrameRemovedEvent& e) override
             {
+                const auto id = getID(e.frame);
+                if(id < handles_.size())
+                {
+                    handles_[id] = FrameHandle{};
+                }
                 removeEntry(e.frame);
             }
+
+            virtual void itemAdded(const envire::core::ItemAddedEvent& e) override
+            {
+                updateHandle(e.frame, e.item, true);
+            }
+
+            virtual void itemRemoved(const envire::core::ItemRemovedEvent& e) override
+            {
+                updateHandle(e.frame, e.item, false);
+            }
+
+            /**
+             * Registers a frame that already existed in the graph before
+             * this manager was subscribed (e.g. the root frame).
+             */
+            void addFrame(const envire::core::FrameId& frame)
+            {
+                addIfUnknown(frame);
+                const auto id = getID(frame);
+                if(id >= handles_.size())
+                {
+                    handles_.resize(id + 1);
+                }
+                handles_[id] = FrameHandle{};
+                handles_[id].vertex = interfaces::ControlCenter::envireGraph->getVertex(frame);
+                handles_[id].known = true;
+                resolveHandle(handles_[id]);
+            }
+
+            /**
+             * Returns the handle of the node with the given id or nullptr if
+             * the id does not belong to a frame.
+             */
+            const FrameHandle* getHandle(unsigned long id) const
+            {
+                if(id >= handles_.size() || !handles_[id].known)
+                {
+                    return nullptr;
+                }
+                return &handles_[id];
+            }
+
+        private:
+            void updateHandle(const envire::core::FrameId& frame, const envire::core::ItemBase::Ptr& item, bool added)
+            {
+                using DynamicObjectEnvireItem = envire::core::Item<interfaces::DynamicObjectItem>;
+                using AbsolutePoseEnvireItem = envire::core::Item<interfaces::AbsolutePose>;
+                const auto id = getID(frame);
+                if(id >= handles_.size() || !handles_[id].known)
+                {
+                    return;
+                }
+
+                // CAUTION: like the rest of the core we assume that there is at most
+                // one DynamicObjectItem and one AbsolutePose in the frame
+                auto& handle = handles_[id];
+                if(const auto dynamicObjectItem = boost::dynamic_pointer_cast<DynamicObjectEnvireItem>(item))
+                {
+                    handle.dynamicObject = added ? dynamicObjectItem->getData().dynamicObject.get() : nullptr;
+                }
+                else if(const auto absolutePoseItem = boost::dynamic_pointer_cast<AbsolutePoseEnvireItem>(item))
+                {
+                    handle.absolutePose = added ? &(absolutePoseItem->getData()) : nullptr;
+                }
+            }
+
+            static void resolveHandle(FrameHandle& handle)
+            {
+                using DynamicObjectEnvireItem = envire::core::Item<interfaces::DynamicObjectItem>;
+                using AbsolutePoseEnvireItem = envire::core::Item<interfaces::AbsolutePose>;
+                const auto& graph = interfaces::ControlCenter::envireGraph;
+
+                // CAUTION: like the rest of the core we assume that there is at most
+                // one DynamicObjectItem and one AbsolutePose in the frame
+                handle.dynamicObject = nullptr;
+                if(graph->containsItems<DynamicObjectEnvireItem>(handle.vertex))
+                {
+                    handle.dynamicObject = graph->getItem<DynamicObjectEnvireItem>(handle.vertex)->getData().dynamicObject.get();
+                }
+                handle.absolutePose = nullptr;
+                if(graph->containsItems<AbsolutePoseEnvireItem>(handle.vertex))
+                {
+                    handle.absolutePose = &(graph->getItem<AbsolutePoseEnvireItem>(handle.vertex)->getData());
+                }
+            }
+
+            std::vector<FrameHandle> handles_;
         };
     }
-}
\ No newline at end of file
+}
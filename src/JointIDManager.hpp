@@ -1,22 +1,34 @@
 #pragma once
 
 #include <string>
+#include <vector>
 #include <mars_interfaces/sim/ControlCenter.h>
 #include <mars_interfaces/sim/IDManager.hpp>
 #include <mars_interfaces/sim/JointInterface.h>
 #include <envire_core/events/GraphItemEventDispatcher.hpp>
 #include <envire_core/items/Item.hpp>
 #include <envire_core/graph/EnvireGraph.hpp>
+#include <envire_core/graph/GraphTypes.hpp>
 
 namespace mars
 {
     namespace core
     {
+        /**
+         * Direct reference to a joint and the frame holding its JointInterfaceItem.
+         * Entries are maintained by the item events of the JointIDManager.
+         */
+        struct JointHandle
+        {
+            std::weak_ptr<interfaces::JointInterface> jointInterface;
+            envire::core::GraphTraits::vertex_descriptor vertex;
+        };
+
         class JointIDManager :  public interfaces::IDManager,
                                 public envire::core::GraphItemEventDispatcher<envire::core::Item<interfaces::JointInterfaceItem>>
         {
         public:
-            JointIDManager(std::shared_ptr<envire::core::EnvireGraph> envireGraph)
+            JointIDManager(std::shared_ptr<envire::core::EnvireGraph> envireGraph) : envireGraph_{envireGraph}
             {
                 GraphItemEventDispatcher<envire::core::Item<interfaces::JointInterfaceItem>>::subscribe(envireGraph.get());
             }
@@ -24,16 +36,59 @@ namespace mars
             virtual void itemAdded(const envire::core::TypedItemAddedEvent<envire::core::Item<interfaces::JointInterfaceItem>>& e) override
             {
                 std::string jointName;
-                e.item->getData().jointInterface->getName(&jointName);
+                const auto& jointInterface = e.item->getData().jointInterface;
+                jointInterface->getName(&jointName);
                 add(jointName);
+
+                const auto id = getID(jointName);
+                if(id >= handles_.size())
+                {
+                    handles_.resize(id + 1);
+                }
+                handles_[id].jointInterface = jointInterface;
+                handles_[id].vertex = envireGraph_->getVertex(e.frame);
             }
 
             virtual void itemRemoved(const envire::core::TypedItemRemovedEvent<envire::core::Item<interfaces::JointInterfaceItem>>& e) override
             {
                 std::string jointName;
                 e.item->getData().jointInterface->getName(&jointName);
+
+                const auto id = getID(jointName);
+                if(id < handles_.size())
+                {
+                    handles_[id] = JointHandle{};
+                }
                 removeEntry(jointName);
             }
+
+            /**
+             * Returns the handle of the joint with the given id or nullptr
+             * if there is no joint registered for it.
+             */
+            const JointHandle* getHandle(unsigned long id) const
+            {
+                if(id >= handles_.size() || handles_[id].jointInterface.expired())
+                {
+                    return nullptr;
+                }
+                return &handles_[id];
+            }
+
+            const std::vector<JointHandle>& getHandles() const
+            {
+                return handles_;
+            }
+
+            void clear()
+            {
+                IDManager::clear();
+                handles_.clear();
+            }
+
+        private:
+            std::shared_ptr<envire::core::EnvireGraph> envireGraph_;
+            std::vector<JointHandle> handles_;
         };
     }
 }
@@ -50,8 +50,6 @@ namespace mars
         using namespace interfaces;
         using namespace std;
 
-        using Iterator = envire::core::EnvireGraph::ItemIterator<envire::core::Item<interfaces::JointInterfaceItem>>;
-
         /**
          *\brief Initialization of a new JointManager
          *
@@ -504,32 +502,35 @@ namespace mars
         {
             // TODO: If value is too large, warn to avoid potential precision issues.
 
-            if(const auto joint = getJointInterface(id).lock())
+            const auto* const handle = idManager_->getHandle(id);
+            if(!handle)
+            {
+                return;
+            }
+            if(const auto joint = handle->jointInterface.lock())
             {
                 const auto jointType = joint->getType();
                 if(jointType == JointType::JOINT_TYPE_HINGE)
                 {
-                    constexpr bool b_isFixedJoint = false;
                     const double& absoluteRotationRad = value;
                     const double currentRotationRad = static_cast<double>(joint->getPosition()); // in (-pi, pi)
                     const double relativeRotationRad = absoluteRotationRad - currentRotationRad;
 
-                    std::string jointName;
-                    joint->getName(&jointName);
-                    envire::core::FrameId jointFrameName = constructFrameIdFromJointName(jointName, b_isFixedJoint);
-                    const auto jointFrameVertex = control->envireGraph_->getVertex(jointFrameName);
+                    // non-fixed joints have their own frame, so the handle vertex is the joint frame
+                    const auto jointFrameVertex = handle->vertex;
 
-                    Simulator* const simulator = dynamic_cast<Simulator*>(control->sim);
-                    if (control->envireGraph->containsItems<envire::core::Item<envire::types::joints::Continuous>>(jointFrameName))
+                    if (control->envireGraph_->containsItems<envire::core::Item<envire::types::joints::Continuous>>(jointFrameVertex))
                     {
-                        simulator->rotateContinuous(jointFrameVertex, relativeRotationRad, control->envireGraph_, control->graphTreeView_);
+                        Simulator::rotateContinuous(jointFrameVertex, relativeRotationRad, control->envireGraph_, control->graphTreeView_);
                     }
-                    else if (control->envireGraph->containsItems<envire::core::Item<envire::types::joints::Revolute>>(jointFrameName))
+                    else if (control->envireGraph_->containsItems<envire::core::Item<envire::types::joints::Revolute>>(jointFrameVertex))
                     {
-                        simulator->rotateRevolute(jointFrameVertex, relativeRotationRad, control->envireGraph_, control->graphTreeView_);
+                        Simulator::rotateRevolute(jointFrameVertex, relativeRotationRad, control->envireGraph_, control->graphTreeView_);
                     }
                     else
                     {
+                        std::string jointName;
+                        joint->getName(&jointName);
                         throw std::logic_error{std::string{"There is no matching envire joint for joint named "} + jointName};
                     }
                 } else
@@ -731,50 +732,25 @@ namespace mars
 
         std::weak_ptr<interfaces::JointInterface> JointManager::getJointInterface(unsigned long jointId)
         {
-            const auto jointName = idManager_->getName(jointId);
-            return getJointInterface(jointName);
+            if(const auto* const handle = idManager_->getHandle(jointId))
+            {
+                return handle->jointInterface;
+            }
+            return std::weak_ptr<interfaces::JointInterface>{};
         }
 
         const std::weak_ptr<interfaces::JointInterface> JointManager::getJointInterface(unsigned long jointId) const
         {
-            const auto jointName = idManager_->getName(jointId);
-            return getJointInterface(jointName);
+            if(const auto* const handle = idManager_->getHandle(jointId))
+            {
+                return handle->jointInterface;
+            }
+            return std::weak_ptr<interfaces::JointInterface>{};
         }
 
         std::weak_ptr<interfaces::JointInterface> JointManager::getJointInterface(const std::string& jointName)
         {
-            auto foundJoint = std::shared_ptr<interfaces::JointInterface>{nullptr};
-            std::shared_ptr<interfaces::JointInterface> *foundJointPtr = &foundJoint;
-            interfaces::ControlCenter *c = control;
-            auto jointInterfaceSearchFunctor = [foundJointPtr, jointName, c](envire::core::GraphTraits::vertex_descriptor node, envire::core::GraphTraits::vertex_descriptor parent) 
-            {
-                // a joint with the given name is already found
-                if(*foundJointPtr)
-                {
-                    return;
-                }
-
-                Iterator begin, end;
-                boost::tie(begin, end) = c->envireGraph_->getItems<envire::core::Item<interfaces::JointInterfaceItem>>(node);
-                for(auto item = begin; item != end; item++)
-                {
-                    std::string currentJointName;
-                    if(!item->getData().jointInterface) {
-                        LOG_ERROR("we have an joint interface item but jointInterface is not set...");
-                        continue;
-                    }
-                    item->getData().jointInterface->getName(&currentJointName);
-                    if(jointName == currentJointName)
-                    {
-                        *foundJointPtr = item->getData().jointInterface;
-                        return;
-                    }
-                }
-            };
-
-            const auto rootVertex = control->envireGraph_->getVertex(SIM_CENTER_FRAME_NAME);
-            control->graphTreeView_->visitBfs(rootVertex, jointInterfaceSearchFunctor);
-            return foundJoint;
+            return getJointInterface(idManager_->getID(jointName));
         }
 
         std::weak_ptr<interfaces::JointInterface> JointManager::getJointInterface(const envire::core::FrameId& linkedFrame0, const envire::core::FrameId& linkedFrame1) const
@@ -806,63 +782,19 @@ namespace mars
 
         const std::weak_ptr<interfaces::JointInterface> JointManager::getJointInterface(const std::string& jointName) const
         {
-            auto foundJoint = std::shared_ptr<interfaces::JointInterface>{nullptr};
-            std::shared_ptr<interfaces::JointInterface> *foundJointPtr = &foundJoint;
-            const interfaces::ControlCenter *c = control;
-            auto jointInterfaceSearchFunctor = [foundJointPtr, jointName, c](envire::core::GraphTraits::vertex_descriptor node, envire::core::GraphTraits::vertex_descriptor parent) 
-            {
-                // a joint with the given name is already found
-                if(*foundJointPtr)
-                {
-                    return;
-                }
-
-                Iterator begin, end;
-                boost::tie(begin, end) = c->envireGraph_->getItems<envire::core::Item<interfaces::JointInterfaceItem>>(node);
-                for(auto item = begin; item != end; item++)
-                {
-                    std::string currentJointName;
-                    if(!item->getData().jointInterface) {
-                        LOG_ERROR("we have an joint interface item but jointInterface is not set...");
-                        continue;
-                    }
-                    item->getData().jointInterface->getName(&currentJointName);
-                    if(jointName == currentJointName)
-                    {
-                        *foundJointPtr = item->getData().jointInterface;
-                        return;
-                    }
-                }
-            };
-
-            const auto rootVertex = control->envireGraph_->getVertex(SIM_CENTER_FRAME_NAME);
-            control->graphTreeView_->visitBfs(rootVertex, jointInterfaceSearchFunctor);
-            return foundJoint;
+            return getJointInterface(idManager_->getID(jointName));
         }
 
         std::list<std::weak_ptr<interfaces::JointInterface>> JointManager::getJoints()
         {
             std::list<std::weak_ptr<interfaces::JointInterface>> joints;
-            interfaces::ControlCenter *c = control;
-            auto jointCollector = [&joints, c](envire::core::GraphTraits::vertex_descriptor node, envire::core::GraphTraits::vertex_descriptor parent)
+            for(const auto& handle : idManager_->getHandles())
             {
-                const auto& numItems = c->envireGraph_->getItemCount<envire::core::Item<JointInterfaceItem>>(node);
-                if(numItems == 0)
-                {
-                    return;
-                }
-
-                const auto typeIndex = std::type_index{typeid(envire::core::Item<mars::interfaces::JointInterfaceItem>)};
-                const auto& items = c->envireGraph_->getItems(node, typeIndex);
-                for(const auto item : items)
+                if(!handle.jointInterface.expired())
                 {
-                    const auto jointItemPtr = boost::dynamic_pointer_cast<envire::core::Item<interfaces::JointInterfaceItem>>(item);
-                    joints.emplace_back(jointItemPtr->getData().jointInterface);
+                    joints.emplace_back(handle.jointInterface);
                 }
-            };
-
-            const auto rootVertex = control->envireGraph_->getVertex(SIM_CENTER_FRAME_NAME);
-            control->graphTreeView_->visitBfs(rootVertex, jointCollector);
+            }
             return joints;
         }
     } // end of namespace core
@@ -433,6 +433,15 @@ namespace mars
             control->graphTreeView_->visitBfs(rootVertex, readdFunctor);
         }
 
+        void MotorManager::resetMotors(void)
+        {
+            const MutexLocker locker{&simMotorsMutex};
+            for(auto& motor: simMotors)
+            {
+                motor.second->resetState();
+            }
+        }
+
         /**
          * \brief This function updates all motors with timing value \c calc_ms in miliseconds.
          *
@@ -233,6 +233,12 @@ namespace mars
              */
             virtual void reloadMotors(void) override;
 
+            /**
+             * \brief Resets the controller state of all motors to the state
+             * after their creation without recreating them.
+             */
+            void resetMotors(void);
+
             /**
              * \brief This function updates all motors with timing value \c calc_ms in miliseconds.
              *
@@ -56,7 +56,9 @@ namespace mars
             idManager_{new FrameIDManager{}},
             libManager{theManager}
         {
-            idManager_->add(SIM_CENTER_FRAME_NAME);
+            // the root frame is created before the id manager subscribes to the graph
+            idManager_->addFrame(SIM_CENTER_FRAME_NAME);
+            rootId_ = idManager_->getID(SIM_CENTER_FRAME_NAME);
 
             if(control->graphics)
             {
@@ -317,12 +319,11 @@ namespace mars
                     obj.name = linkName;
                 }
 
-                using AbsolutePoseEnvireItem = envire::core::Item<interfaces::AbsolutePose>;
-                if (control->envireGraph_->containsFrame(linkName) && control->envireGraph_->containsItems<AbsolutePoseEnvireItem>(linkName))
+                const auto* const handle = idManager_->getHandle(id);
+                if (handle && handle->absolutePose)
                 {
-                    const auto& absolutePose = control->envireGraph_->getItem<AbsolutePoseEnvireItem>(linkName)->getData();
-                    obj.pos = absolutePose.getPosition();
-                    obj.rot = absolutePose.getRotation();
+                    obj.pos = handle->absolutePose->getPosition();
+                    obj.rot = handle->absolutePose->getRotation();
                 }
                 else
                 {
@@ -872,37 +873,35 @@ namespace mars
 
         interfaces::DynamicObject* NodeManager::getDynamicObject(const NodeId& node_id) const
         {
-            const auto& nodeName = idManager_->getName(node_id);
-            if (!control->envireGraph_->containsFrame(nodeName))
+            const auto* const handle = idManager_->getHandle(node_id);
+            if (!handle)
             {
+                const auto& nodeName = idManager_->getName(node_id);
                 LOG_WARN(std::string{"NodeManager::getDynamicObject: Node named \"" + nodeName + "\" does not represent a frame."}.c_str());
                 return nullptr;
             }
 
-            const auto& vertex = control->envireGraph_->getVertex(nodeName);
-            using DynamicObjectEnvireItem = envire::core::Item<interfaces::DynamicObjectItem>;
-            if (!control->envireGraph_->containsItems<DynamicObjectEnvireItem>(vertex))
+            if (!handle->dynamicObject)
             {
+                const auto& nodeName = idManager_->getName(node_id);
                 LOG_WARN(std::string{"NodeManager::getDynamicObject: Frame \"" + nodeName + "\" does not contain a DynamicObjectItem."}.c_str());
                 return nullptr;
             }
 
-            return control->envireGraph_->getItem<DynamicObjectEnvireItem>(vertex)->getData().dynamicObject.get();
+            return handle->dynamicObject;
         }
 
 
         interfaces::AbsolutePose& NodeManager::getAbsolutePose(const interfaces::NodeId& node_id) const
         {
             // Method shall only be called for nodes representing frames
-            const auto& nodeName = idManager_->getName(node_id);
-            assert(control->envireGraph_->containsFrame(nodeName));
+            const auto* const handle = idManager_->getHandle(node_id);
+            assert(handle);
 
             // Method shall only be called for nodes containing AbsolutePose instances.
-            const auto& vertex = control->envireGraph_->getVertex(nodeName);
-            using AbsolutePoseEnvireItem = envire::core::Item<AbsolutePose>;
-            assert(control->envireGraph_->containsItems<AbsolutePoseEnvireItem>(vertex));
+            assert(handle->absolutePose);
 
-            return control->envireGraph_->getItem<AbsolutePoseEnvireItem>(vertex)->getData();
+            return *(handle->absolutePose);
         }
 
         void NodeManager::moveDynamicObjects(const interfaces::NodeId& node_id, const utils::Vector& translation, const bool move_all)
@@ -1976,13 +1975,7 @@ namespace mars
 
         bool NodeManager::isRootFrame(const interfaces::NodeId& node_id) const
         {
-            if (!idManager_->isKnown(node_id))
-            {
-                return false;
-            }
-
-            const auto& nodeName = idManager_->getName(node_id);
-            return nodeName == SIM_CENTER_FRAME_NAME;
+            return node_id == rootId_;
         }
     } // end of namespace core
 } // end of namespace mars
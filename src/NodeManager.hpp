@@ -175,6 +175,7 @@ namespace mars
             lib_manager::LibManager *libManager;
             interfaces::ControlCenter *control;
             std::unique_ptr<FrameIDManager> idManager_;
+            interfaces::NodeId rootId_;
 
             void removeNode(interfaces::NodeId id, bool lock,
                             bool clearGraphics=true);
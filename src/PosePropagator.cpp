@@ -0,0 +1,231 @@
+/**
+ * \file PosePropagator.cpp
+ */
+
+#include "PosePropagator.hpp"
+
+#include <mars_interfaces/sim/ControlCenter.h>
+
+namespace mars
+{
+    namespace core
+    {
+        using namespace interfaces;
+
+        PosePropagator::PosePropagator(std::shared_ptr<envire::core::EnvireGraph> envireGraph,
+                                       std::shared_ptr<envire::core::TreeView> graphTreeView) :
+            envireGraph{envireGraph}, graphTreeView{graphTreeView},
+            structureChanged{true}, forceUpdate{true}, updating{false}
+        {
+            GraphEventDispatcher::subscribe(envireGraph.get());
+        }
+
+        PosePropagator::~PosePropagator()
+        {
+            GraphEventDispatcher::unsubscribe();
+        }
+
+        void PosePropagator::invalidate()
+        {
+            forceUpdate = true;
+        }
+
+        void PosePropagator::frameAdded(const envire::core::FrameAddedEvent& e)
+        {
+            structureChanged = true;
+        }
+
+        void PosePropagator::frameRemoved(const envire::core::FrameRemovedEvent& e)
+        {
+            structureChanged = true;
+        }
+
+        void PosePropagator::edgeAdded(const envire::core::EdgeAddedEvent& e)
+        {
+            structureChanged = true;
+        }
+
+        void PosePropagator::edgeRemoved(const envire::core::EdgeRemovedEvent& e)
+        {
+            structureChanged = true;
+        }
+
+        void PosePropagator::edgeModified(const envire::core::EdgeModifiedEvent& e)
+        {
+            // transforms set by others (e.g. when editing or resetting nodes)
+            // are not covered by the dirty tracking
+            if(!updating)
+            {
+                forceUpdate = true;
+            }
+        }
+
+        void PosePropagator::itemAdded(const envire::core::ItemAddedEvent& e)
+        {
+            // the plan caches pointers to these items
+            if(boost::dynamic_pointer_cast<envire::core::Item<DynamicObjectItem>>(e.item) ||
+               boost::dynamic_pointer_cast<envire::core::Item<AbsolutePose>>(e.item))
+            {
+                structureChanged = true;
+            }
+        }
+
+        void PosePropagator::itemRemoved(const envire::core::ItemRemovedEvent& e)
+        {
+            if(boost::dynamic_pointer_cast<envire::core::Item<DynamicObjectItem>>(e.item) ||
+               boost::dynamic_pointer_cast<envire::core::Item<AbsolutePose>>(e.item))
+            {
+                structureChanged = true;
+            }
+        }
+
+        void PosePropagator::updatePlan()
+        {
+            if(structureChanged)
+            {
+                buildPlan();
+            }
+        }
+
+        void PosePropagator::update()
+        {
+            if(structureChanged)
+            {
+                // wait for updatePlan()
+                return;
+            }
+            const bool force = forceUpdate.exchange(false);
+
+            updating = true;
+            const Pose identity{base::Position::Zero(), base::Orientation::Identity()};
+            const auto now = base::Time::now();
+            for(size_t i = 0; i < plan.size();)
+            {
+                const auto& entry = plan[i];
+                const bool parentChanged = entry.parent < 0 ? force : changed[entry.parent];
+                if(!parentChanged && !entry.dynamicSubtree)
+                {
+                    // static subtree below an unchanged frame keeps its poses
+                    i = entry.subtreeEnd;
+                    continue;
+                }
+                const Pose& rootToParent = entry.parent < 0 ? identity : rootTransforms[entry.parent];
+                Pose& rootToFrame = rootTransforms[i];
+                Pose& local = localTransforms[i];
+
+                if(entry.dynamicSlot >= 0)
+                {
+                    dynamicObjects[entry.dynamicSlot]->getPosition(&rootToFrame.position);
+                    dynamicObjects[entry.dynamicSlot]->getRotation(&rootToFrame.rotation);
+                    Pose& last = lastDynamicPoses[i];
+                    const bool moved = force ||
+                        rootToFrame.position != last.position ||
+                        rootToFrame.rotation.coeffs() != last.rotation.coeffs();
+                    last = rootToFrame;
+
+                    if(moved || parentChanged)
+                    {
+                        // calculate the relative pose of the frame
+                        const base::Orientation parentToRoot = rootToParent.rotation.conjugate();
+                        local.position = parentToRoot * (rootToFrame.position - rootToParent.position);
+                        local.rotation = parentToRoot * rootToFrame.rotation;
+                        // keep the covariance and the rest of the edge
+                        auto tf = envireGraph->getTransform(entry.origin, entry.target);
+                        tf.transform.translation = local.position;
+                        tf.transform.orientation = local.rotation;
+                        tf.time = now;
+                        envireGraph->updateTransform(entry.origin, entry.target, tf);
+                    }
+                    // the absolute pose of a dynamic frame only depends on its object
+                    changed[i] = moved;
+                }
+                else
+                {
+                    if(force)
+                    {
+                        const auto& tf = envireGraph->getTransform(entry.origin, entry.target).transform;
+                        local.position = tf.translation;
+                        local.rotation = tf.orientation;
+                    }
+                    if(parentChanged)
+                    {
+                        rootToFrame.position = rootToParent.position + rootToParent.rotation * local.position;
+                        rootToFrame.rotation = rootToParent.rotation * local.rotation;
+                    }
+                    changed[i] = parentChanged;
+                }
+
+                if(changed[i] && entry.absolutePose)
+                {
+                    entry.absolutePose->setPosition(rootToFrame.position);
+                    entry.absolutePose->setRotation(rootToFrame.rotation);
+                }
+                ++i;
+            }
+            updating = false;
+        }
+
+        void PosePropagator::buildPlan()
+        {
+            structureChanged = false;
+            plan.clear();
+            dynamicObjects.clear();
+            const auto rootVertex = envireGraph->getVertex(SIM_CENTER_FRAME_NAME);
+            const auto it = graphTreeView->tree.find(rootVertex);
+            if(it != graphTreeView->tree.end())
+            {
+                for(const auto& child : it->second.children)
+                {
+                    addToPlan(rootVertex, child, -1);
+                }
+            }
+
+            const Pose identity{base::Position::Zero(), base::Orientation::Identity()};
+            localTransforms.assign(plan.size(), identity);
+            rootTransforms.assign(plan.size(), identity);
+            lastDynamicPoses.assign(plan.size(), identity);
+            changed.assign(plan.size(), 0);
+            forceUpdate = true;
+        }
+
+        size_t PosePropagator::addToPlan(VertexDesc origin, VertexDesc target, long parent)
+        {
+            const size_t index = plan.size();
+            PlanEntry entry;
+            entry.parent = parent;
+            entry.origin = origin;
+            entry.target = target;
+            entry.dynamicSlot = -1;
+            entry.absolutePose = nullptr;
+            // CAUTION: we assume that there is at most one DynamicObjectItem and one AbsolutePose in the frame
+            if(envireGraph->containsItems<envire::core::Item<DynamicObjectItem>>(target))
+            {
+                entry.dynamicSlot = dynamicObjects.size();
+                dynamicObjects.push_back(envireGraph->getItem<envire::core::Item<DynamicObjectItem>>(target)->getData().dynamicObject.get());
+            }
+            if(envireGraph->containsItems<envire::core::Item<AbsolutePose>>(target))
+            {
+                entry.absolutePose = &(envireGraph->getItem<envire::core::Item<AbsolutePose>>(target)->getData());
+            }
+            entry.dynamicSubtree = entry.dynamicSlot >= 0;
+            plan.push_back(entry);
+
+            // plan grows while adding the children, so plan[index] is accessed by index only
+            const auto it = graphTreeView->tree.find(target);
+            if(it != graphTreeView->tree.end())
+            {
+                for(const auto& child : it->second.children)
+                {
+                    const size_t childIndex = addToPlan(target, child, index);
+                    if(plan[childIndex].dynamicSubtree)
+                    {
+                        plan[index].dynamicSubtree = true;
+                    }
+                }
+            }
+            plan[index].subtreeEnd = plan.size();
+            return index;
+        }
+
+    } // end of namespace core
+} // end of namespace mars
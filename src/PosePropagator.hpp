@@ -0,0 +1,117 @@
+/**
+ * \file PosePropagator.hpp
+ * \brief Propagates the poses of the dynamic objects into the envire graph.
+ *
+ */
+
+#pragma once
+
+#include <envire_core/items/Item.hpp>
+#include <envire_core/events/GraphEventDispatcher.hpp>
+#include <envire_core/graph/EnvireGraph.hpp>
+#include <envire_core/graph/TreeView.hpp>
+#include <base/Eigen.hpp>
+#include <base/Time.hpp>
+#include <mars_interfaces/sim/AbsolutePose.hpp>
+#include <mars_interfaces/sim/DynamicObject.hpp>
+
+#include <Eigen/StdVector>
+#include <atomic>
+#include <vector>
+
+namespace mars
+{
+    namespace core
+    {
+        /**
+         * \brief Updates the relative transforms and AbsolutePose items of
+         * the graph from the poses of the DynamicObjects.
+         *
+         * The tree below the root frame is flattened into a plan in depth
+         * first order, so every frame comes after its parent and each
+         * subtree is a contiguous range. The plan caches the item pointers
+         * and the local transforms of the static frames. It is rebuilt when
+         * the graph structure changes and executed as a single loop.
+         *
+         * Only frames below a dynamic object that moved since the last
+         * update are recomputed. Subtrees without dynamic objects are
+         * skipped as long as their parent frame did not change. A transform
+         * changed by someone else leads to a full update.
+         *
+         * The physics thread reads the AbsolutePose items while stepping,
+         * so the plan is built and executed with the physics blocked.
+         */
+        class PosePropagator : public envire::core::GraphEventDispatcher
+        {
+        public:
+            PosePropagator(std::shared_ptr<envire::core::EnvireGraph> envireGraph,
+                           std::shared_ptr<envire::core::TreeView> graphTreeView);
+            ~PosePropagator();
+
+            /**
+             * Rebuilds the plan if the graph structure changed.
+             * Must be called with the physics blocked.
+             */
+            void updatePlan();
+
+            /**
+             * Propagates the poses of the dynamic objects that moved since
+             * the last update through the graph.
+             * Must be called with the physics blocked.
+             */
+            void update();
+
+            /**
+             * Recomputes all frames on the next update.
+             */
+            void invalidate();
+
+            virtual void frameAdded(const envire::core::FrameAddedEvent& e) override;
+            virtual void frameRemoved(const envire::core::FrameRemovedEvent& e) override;
+            virtual void edgeAdded(const envire::core::EdgeAddedEvent& e) override;
+            virtual void edgeRemoved(const envire::core::EdgeRemovedEvent& e) override;
+            virtual void edgeModified(const envire::core::EdgeModifiedEvent& e) override;
+            virtual void itemAdded(const envire::core::ItemAddedEvent& e) override;
+            virtual void itemRemoved(const envire::core::ItemRemovedEvent& e) override;
+
+        private:
+            using VertexDesc = envire::core::GraphTraits::vertex_descriptor;
+
+            struct PlanEntry
+            {
+                long parent; ///< index of the parent entry, -1 for children of the root frame
+                size_t subtreeEnd; ///< one past the last entry of the subtree
+                bool dynamicSubtree; ///< the frame or one of its descendants holds a dynamic object
+                VertexDesc origin, target;
+                long dynamicSlot; ///< index into dynamicObjects, -1 for static frames
+                interfaces::AbsolutePose *absolutePose;
+            };
+
+            /** Lightweight transform, the covariance of the graph transforms is not needed here. */
+            struct Pose
+            {
+                base::Position position;
+                base::Orientation rotation;
+            };
+            using PoseVector = std::vector<Pose, Eigen::aligned_allocator<Pose>>;
+
+            void buildPlan();
+            size_t addToPlan(VertexDesc origin, VertexDesc target, long parent);
+
+            // plan and per entry state, all indexed by the entry
+            std::vector<PlanEntry> plan;
+            PoseVector localTransforms; ///< parent to frame
+            PoseVector rootTransforms; ///< root to frame
+            PoseVector lastDynamicPoses;
+            std::vector<char> changed;
+            std::vector<interfaces::DynamicObject*> dynamicObjects;
+
+            std::shared_ptr<envire::core::EnvireGraph> envireGraph;
+            std::shared_ptr<envire::core::TreeView> graphTreeView;
+            // the graph events can be emitted by any thread
+            std::atomic<bool> structureChanged;
+            std::atomic<bool> forceUpdate;
+            std::atomic<bool> updating; ///< set while update() modifies the graph to ignore its own events
+        };
+    } // end of namespace core
+} // end of namespace mars
@@ -0,0 +1,38 @@
+/**
+ * \file RayCaster.hpp
+ * \brief Batched ray queries against the collision spaces of all subworlds.
+ *
+ */
+
+#pragma once
+
+#include "VectorArray.hpp"
+
+#include <mars_interfaces/MARSDefs.h>
+
+namespace mars
+{
+    namespace core
+    {
+        /**
+         * Casts batches of rays. Implemented by the Simulator and handed to
+         * the ray sensors by the SensorManager.
+         */
+        class RayCaster
+        {
+        public:
+            virtual ~RayCaster() {}
+
+            /**
+             * Writes the collision distance of the ray origins[i] +
+             * directions[i] into out[i], the length of the direction if the
+             * ray hits nothing.
+             * \param out has to hold at least origins.size() values.
+             * \param parallel allows to split the rays across threads, the
+             * result does not depend on it.
+             */
+            virtual void getVectorCollisions(const VectorArray &origins, const VectorArray &directions,
+                                             interfaces::sReal *out, bool parallel = false) = 0;
+        };
+    } // end of namespace core
+} // end of namespace mars
@@ -0,0 +1,138 @@
+/**
+ * \file SensorDataView.hpp
+ * \brief Read-only, zero-copy access to the data of a sensor.
+ *
+ */
+
+#pragma once
+
+#include <mars_interfaces/MARSDefs.h>
+#include <mars_utils/Mutex.h>
+#include <mars_utils/MutexLocker.h>
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+namespace mars
+{
+    namespace core
+    {
+        /**
+         * \brief A read-only view on a published sensor buffer.
+         *
+         * The view keeps the buffer alive, so it stays valid and unchanged
+         * while it is held, even if the sensor publishes newer data
+         * meanwhile. The sequence number increases with every publication
+         * and can be compared to skip data that was already processed.
+         */
+        class SensorDataView
+        {
+        public:
+            SensorDataView() : sequence{0} {}
+
+            const interfaces::sReal* data() const
+            {
+                return buffer ? buffer->data() : nullptr;
+            }
+
+            size_t size() const
+            {
+                return buffer ? buffer->size() : 0;
+            }
+
+            bool empty() const
+            {
+                return size() == 0;
+            }
+
+            std::shared_ptr<const std::vector<interfaces::sReal>> buffer;
+            unsigned long sequence;
+        };
+
+        /**
+         * \brief Double buffered storage a sensor publishes its data with.
+         *
+         * The writer fills the buffer returned by beginWrite() and makes it
+         * current with publish(). A buffer that is still referenced by a
+         * reader's view is never written again; a fresh one is allocated
+         * in that case, so steady-state publishing does not allocate.
+         *
+         * Every view holds a read lease on its slot. Taking the lease
+         * increments the reader count of the slot under the mutex and
+         * dropping it decrements the count with release semantics. The
+         * writer checks the count with acquire semantics, so all reads of a
+         * released view happen before the slot is written again.
+         */
+        class SensorDataBuffer
+        {
+        public:
+            SensorDataBuffer() : sequence{0} {}
+
+            std::vector<interfaces::sReal>& beginWrite(size_t size)
+            {
+                if(!back || back->readers.load(std::memory_order_acquire) > 0)
+                {
+                    back = std::make_shared<Slot>();
+                }
+                back->data.resize(size);
+                return back->data;
+            }
+
+            void publish()
+            {
+                utils::MutexLocker locker{&mutex};
+                current.swap(back);
+                ++sequence;
+            }
+
+            SensorDataView getView() const
+            {
+                utils::MutexLocker locker{&mutex};
+                SensorDataView view;
+                if(current)
+                {
+                    // the count is incremented before the slot can become the
+                    // back buffer again, which needs the mutex in publish()
+                    current->readers.fetch_add(1, std::memory_order_relaxed);
+                    auto lease = std::make_shared<ReadLease>(current);
+                    view.buffer = std::shared_ptr<const std::vector<interfaces::sReal>>{lease, &current->data};
+                }
+                view.sequence = sequence;
+                return view;
+            }
+
+        private:
+            struct Slot
+            {
+                std::vector<interfaces::sReal> data;
+                std::atomic<int> readers{0};
+            };
+
+            struct ReadLease
+            {
+                explicit ReadLease(const std::shared_ptr<Slot> &slot) : slot{slot} {}
+                ~ReadLease()
+                {
+                    slot->readers.fetch_sub(1, std::memory_order_release);
+                }
+                std::shared_ptr<Slot> slot;
+            };
+
+            mutable utils::Mutex mutex;
+            std::shared_ptr<Slot> current, back;
+            unsigned long sequence;
+        };
+
+        /**
+         * \brief Mix-in for sensors that publish their data through a
+         * SensorDataBuffer and support SensorManager::getSensorDataView().
+         */
+        class SensorDataProvider
+        {
+        public:
+            virtual ~SensorDataProvider() {}
+            virtual SensorDataView getSensorDataView() const = 0;
+        };
+    } // end of namespace core
+} // end of namespace mars
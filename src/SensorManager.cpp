@@ -46,7 +46,9 @@
 // TODO: itemRemover from JointManager.hpp needed. Remove include as soon as the function is moved to a central location.
 #include "JointManager.hpp"
 
+#include <algorithm>
 #include <cstdio>
+#include <cstdlib>
 #include <stdexcept>
 
 namespace mars
@@ -63,9 +65,10 @@ namespace mars
          * \brief Constructor.
          *
          * \param c The pointer to the ControlCenter of the simulation.
+         * \param rayCaster Handed to the sensors that cast rays.
          */
-        SensorManager::SensorManager(ControlCenter *c)
-            : control{c}, idManager_{new interfaces::IDManager{}}
+        SensorManager::SensorManager(ControlCenter *c, RayCaster *rayCaster)
+            : control{c}, rayCaster{rayCaster}, idManager_{new interfaces::IDManager{}}
         {
             addSensorTypes();
             addMarsParsers();
@@ -73,8 +76,8 @@ namespace mars
 
         void SensorManager::addSensorTypes()
         {
-            addSensorType("RaySensor",&RaySensor::instanciate);
-            addSensorType("RotatingRaySensor",&RotatingRaySensor::instanciate);
+            addRayCastingSensorType("RaySensor",&RaySensor::instanciate);
+            addRayCastingSensorType("RotatingRaySensor",&RotatingRaySensor::instanciate);
             // addSensorType("MultiLevelLaserRangeFinder",&MultiLevelLaserRangeFinder::instanciate);
             addSensorType("CameraSensor",&CameraSensor::instanciate);
             // addSensorType("ScanningSonar",&ScanningSonar::instanciate);
@@ -266,6 +269,37 @@ namespace mars
             return 0;
         }
 
+        bool SensorManager::getSensorDataView(unsigned long id, SensorDataView *view) const
+        {
+            const MutexLocker locker{&simSensorsMutex};
+
+            const auto iter = simSensors.find(id);
+            if(iter == simSensors.end())
+            {
+                LOG_DEBUG((std::string{"Cannot Find Sensor with id: "} + std::to_string(id)).c_str());
+                return false;
+            }
+
+            if(const auto* provider = dynamic_cast<const SensorDataProvider*>(iter->second))
+            {
+                *view = provider->getSensorDataView();
+                return true;
+            }
+
+            // compatibility path for sensors that only implement getSensorData
+            sReal *data = nullptr;
+            const int size = iter->second->getSensorData(&data);
+            auto buffer = std::make_shared<std::vector<sReal>>();
+            if(data)
+            {
+                buffer->assign(data, data + std::max(size, 0));
+                free(data);
+            }
+            view->buffer = buffer;
+            view->sequence = 0;
+            return true;
+        }
+
 
         /**
          *\brief Returns the number of sensors that are currently present in the simulation.
@@ -345,12 +379,18 @@ namespace mars
             availableSensors.insert(std::pair<const std::string,BaseSensor* (*)(ControlCenter*,BaseConfig*)>(name,func));
         }
 
+        void SensorManager::addRayCastingSensorType(const std::string &name, BaseSensor* (*func)(ControlCenter*, BaseConfig*, RayCaster*))
+        {
+            rayCastingSensors.insert(std::pair<const std::string,BaseSensor* (*)(ControlCenter*,BaseConfig*,RayCaster*)>(name,func));
+        }
+
        unsigned long SensorManager::createAndAddSensor(const std::string &type_name, BaseConfig *config, bool reload)
        {
             // TODO: This should be moved to envire_mars_sensors and instead add an envire sensor item to the envire graph.
             assert(config);
             const auto it = availableSensors.find(type_name);
-            if(it == availableSensors.end())
+            const auto rayCastingIt = rayCastingSensors.find(type_name);
+            if(it == availableSensors.end() && rayCastingIt == rayCastingSensors.end())
             {
                 std::cerr << "Could not load unknown Sensor with name: \"" << type_name << "\"" << std::endl;
                 return 0;
@@ -365,7 +405,9 @@ namespace mars
             }
             config->id = idManager_->addIfUnknown(config->name);
 
-            BaseSensor *sensor = ((*it).second)(this->control, config); // This copies config
+            // This copies config
+            BaseSensor *sensor = it != availableSensors.end() ? ((*it).second)(this->control, config)
+                                                              : ((*rayCastingIt).second)(this->control, config, rayCaster);
             delete config;
             simSensorsMutex.lock();
             simSensors[sensor->getID()] = sensor;
@@ -10,6 +10,9 @@
 
 #pragma once
 
+#include "RayCaster.hpp"
+#include "SensorDataView.hpp"
+
 #include <mars_interfaces/sim/SensorManagerInterface.h>
 #include <mars_interfaces/sim/ControlCenter.h>
 #include <mars_utils/Mutex.h>
@@ -48,8 +51,10 @@ namespace mars
              * \brief Constructor.
              *
              * \param c The pointer to the ControlCenter of the simulation.
+             * \param rayCaster Handed to the sensors that cast rays, they
+             * fall back to single rays via ControlCenter::sim without it.
              */
-            SensorManager(interfaces::ControlCenter *c);
+            SensorManager(interfaces::ControlCenter *c, RayCaster *rayCaster = nullptr);
 
             /**
              * \brief Destructor.
@@ -152,6 +157,21 @@ namespace mars
              */
             virtual int getSensorData(unsigned long id, interfaces::sReal **data) const override;
 
+            /**
+             * \brief Provides read-only access to the current data of a sensor
+             * without copying it.
+             *
+             * \details Compare the sequence of the view with the one of the
+             * previous call to detect new data. Sensors that do not publish
+             * their data through a SensorDataBuffer are served by copying the
+             * result of getSensorData() into a new buffer.
+             *
+             * \param id The id of the sensor.
+             * \param view Receives the view on the sensor data.
+             * \returns \c false if there is no sensor with the given id.
+             */
+            bool getSensorDataView(unsigned long id, SensorDataView *view) const;
+
             /**
              *\brief Returns the number of sensors that are currently present in the simulation.
              *
@@ -181,6 +201,7 @@ namespace mars
             //virtual void addSensorType(const std::string &name,  BaseSensor* (*func)(interfaces::ControlCenter*,const unsigned long int,const std::string,QDomElement*));
             //void addSensorType(const std::string &name, BaseSensor* (*func)(interfaces::ControlCenter*,const unsigned long int, const std::string, mars::ConfigMap*));
             void addSensorType(const std::string &name, interfaces::BaseSensor* (*func)(interfaces::ControlCenter*, interfaces::BaseConfig*));
+            void addRayCastingSensorType(const std::string &name, interfaces::BaseSensor* (*func)(interfaces::ControlCenter*, interfaces::BaseConfig*, RayCaster*));
 
             //void addQdomParser(const std::string, BaseConfig* (*)(QDomElement*));
             void addMarsParser(const std::string, interfaces::BaseConfig* (*)(interfaces::ControlCenter*, configmaps::ConfigMap*));
@@ -196,6 +217,7 @@ namespace mars
 
             //! a pointer to the control center
             interfaces::ControlCenter *control;
+            RayCaster *rayCaster;
 
             //! a containter for all sensors currently present in the simulation
             std::map<unsigned long, interfaces::BaseSensor*> simSensors;
@@ -207,6 +229,7 @@ namespace mars
             //std::map<const std::string,BaseSensor* (*)(interfaces::ControlCenter*,const unsigned long int,const std::string,QDomElement*)> availibleSensors;
             //std::map<const std::string,BaseSensor* (*)(interfaces::ControlCenter*,const unsigned long int, const std::string, mars::ConfigMap*)> availableSensors2;
             std::map<const std::string, interfaces::BaseSensor* (*)(interfaces::ControlCenter*, interfaces::BaseConfig*)> availableSensors;
+            std::map<const std::string, interfaces::BaseSensor* (*)(interfaces::ControlCenter*, interfaces::BaseConfig*, RayCaster*)> rayCastingSensors;
 
             //std::map<const std::string,BaseConfig* (*)(QDomElement*)> qDomParser;
             std::map<const std::string, interfaces::BaseConfig* (*)(interfaces::ControlCenter*, configmaps::ConfigMap*)> marsParser;
@@ -49,7 +49,7 @@ namespace mars
             position = &position1;
             lastVelocity = velocity=0;
             joint_velocity = 0;
-            time = 10;
+            time = initialTime;
             current = 0;
             sensedEffort = effort = 0;
             tmpmaxeffort = 0;
@@ -170,6 +170,76 @@ namespace mars
             mimic_offset = offset;
         }
 
+        SimMotor::State SimMotor::getState() const
+        {
+            State state;
+            state.time = time;
+            state.lastVelocity = lastVelocity;
+            state.velocity = velocity;
+            state.position1 = position1;
+            state.position2 = position2;
+            state.effort = effort;
+            state.sensedEffort = sensedEffort;
+            state.current = current;
+            state.temperature = temperature;
+            state.feedForwardEffort = feedForwardEffort;
+            state.feedForwardEffortIntern = feedForwardEffortIntern;
+            state.controlValue = controlValue;
+            state.last_error = last_error;
+            state.integ_error = integ_error;
+            state.joint_velocity = joint_velocity;
+            state.error = error;
+            state.posPID = posPID;
+            state.velPID = velPID;
+            return state;
+        }
+
+        void SimMotor::setState(const State &state)
+        {
+            time = state.time;
+            lastVelocity = state.lastVelocity;
+            velocity = state.velocity;
+            position1 = state.position1;
+            position2 = state.position2;
+            effort = state.effort;
+            sensedEffort = state.sensedEffort;
+            current = state.current;
+            temperature = state.temperature;
+            feedForwardEffort = state.feedForwardEffort;
+            feedForwardEffortIntern = state.feedForwardEffortIntern;
+            controlValue = state.controlValue;
+            last_error = state.last_error;
+            integ_error = state.integ_error;
+            joint_velocity = state.joint_velocity;
+            error = state.error;
+            // keep the gains and limits, they may have been changed since
+            for(auto pid: {std::make_pair(&posPID, &state.posPID), std::make_pair(&velPID, &state.velPID)})
+            {
+                pid.first->last_value = pid.second->last_value;
+                pid.first->last_error = pid.second->last_error;
+                pid.first->last_i = pid.second->last_i;
+                pid.first->current_value = pid.second->current_value;
+                pid.first->target_value = pid.second->target_value;
+                pid.first->output_value = pid.second->output_value;
+            }
+        }
+
+        void SimMotor::resetState()
+        {
+            State state = getState();
+            state.time = initialTime;
+            state.lastVelocity = state.velocity = 0;
+            state.position1 = state.position2 = 0;
+            state.effort = state.sensedEffort = 0;
+            state.current = state.temperature = 0;
+            state.feedForwardEffort = state.feedForwardEffortIntern = 0;
+            state.controlValue = 0;
+            state.last_error = state.integ_error = 0;
+            state.joint_velocity = state.error = 0;
+            state.posPID = state.velPID = PID{};
+            setState(state);
+        }
+
         void SimMotor::setMaxEffortApproximation(utils::ApproximationFunction type,
                                                  std::vector<double>* coefficients)
         {
@@ -44,6 +44,21 @@ namespace mars
         {
 
         public:
+            /**
+             * The time dependent state of the motor and its controllers,
+             * used to checkpoint a simulation. The configuration and the
+             * gains are not part of the state.
+             */
+            struct State
+            {
+                interfaces::sReal time;
+                interfaces::sReal lastVelocity, velocity, position1, position2;
+                interfaces::sReal effort, sensedEffort, current, temperature;
+                interfaces::sReal feedForwardEffort, feedForwardEffortIntern;
+                interfaces::sReal controlValue, last_error, integ_error, joint_velocity, error;
+                PID posPID, velPID;
+            };
+
             SimMotor(interfaces::ControlCenter *control,
                      const interfaces::MotorData &sMotor,
                      std::weak_ptr<interfaces::JointInterface> joint);
@@ -126,6 +141,10 @@ namespace mars
             void setFeedForwardTorque(interfaces::sReal value);
             void setMimic(interfaces::sReal multiplier, interfaces::sReal offset);
 
+            State getState() const;
+            void setState(const State &state);
+            void resetState(); ///< the state after the construction, keeps the gains
+
 
             // methods inherited from data broker interfaces
             virtual void produceData(const data_broker::DataInfo &info,
@@ -172,6 +191,8 @@ namespace mars
             interfaces::ControlCenter *control;
             interfaces::MotorData sMotor;
             std::weak_ptr<interfaces::JointInterface> joint;
+            /// ms, the step time assumed until the first update
+            static constexpr interfaces::sReal initialTime = 10;
             interfaces::sReal time;
             interfaces::sReal lastVelocity, velocity, position1, position2, effort;
             interfaces::sReal sensedEffort;
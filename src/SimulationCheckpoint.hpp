@@ -0,0 +1,66 @@
+/**
+ * \file SimulationCheckpoint.hpp
+ * \brief The dynamic state of a simulation, restorable without reloading the scene.
+ *
+ */
+
+#pragma once
+
+#include "SimMotor.hpp"
+
+#include <mars_utils/Vector.h>
+#include <mars_utils/Quaternion.h>
+
+#include <Eigen/StdVector>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace mars
+{
+    namespace core
+    {
+        /**
+         * \brief Snapshot of the state that changes while the simulation runs.
+         *
+         * The bodies are identified by the frame of their DynamicObject, the
+         * joints and motors by their names, since ids are assigned at runtime
+         * and differ between two loads of a scene. A checkpoint can only be
+         * restored into a scene with the same bodies, joints and motors, the
+         * objects are not recreated. The joint positions follow from the body
+         * poses, they are stored to detect a checkpoint that does not fit the
+         * scene.
+         */
+        struct SimulationCheckpoint
+        {
+            struct BodyState
+            {
+                std::string frame;
+                utils::Vector position;
+                utils::Quaternion rotation;
+                utils::Vector linearVelocity;
+                utils::Vector angularVelocity;
+            };
+
+            struct JointState
+            {
+                std::string name;
+                interfaces::sReal position;
+                interfaces::sReal velocity;
+            };
+
+            double simTime; ///< ms
+            std::vector<BodyState, Eigen::aligned_allocator<BodyState>> bodies;
+            std::vector<JointState> joints;
+            std::map<std::string, SimMotor::State> motors; ///< by motor name
+        };
+
+        /**
+         * Writes the checkpoint to a binary boost archive. The format
+         * depends on the platform and is meant to be read by the same build.
+         */
+        bool writeCheckpoint(const SimulationCheckpoint &checkpoint, const std::string &filename);
+        /** Returns false if the file cannot be read or is not a checkpoint. */
+        bool readCheckpoint(const std::string &filename, SimulationCheckpoint *checkpoint);
+    } // end of namespace core
+} // end of namespace mars
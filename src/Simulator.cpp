@@ -21,6 +21,7 @@
 #include "NodeManager.hpp"
 #include "FrameIDManager.hpp"
 #include "JointIDManager.hpp"
+#include "Tracer.hpp"
 
 //#include "PhysicsMapper.h"
 
@@ -69,8 +70,11 @@
 #include <getopt.h>
 #include <stdexcept>
 #include <algorithm>
+#include <cassert>
 #include <cctype> // for tolower()
 #include <chrono>
+#include <cmath>
+#include <map>
 
 #ifdef __linux__
 #include <time.h>
@@ -104,6 +108,65 @@ namespace mars
 
         Simulator *Simulator::activeSimulator = 0;
 
+        // number of rays handled by one task of a parallel collision query
+        static const size_t rays_per_task = 256;
+
+        // Slab test of the segment origin + t*ray, t in [0, 1], against the
+        // bounds. On a hit tEnter is set to the parameter where the segment
+        // enters the box.
+        static bool rayHitsBounds(const Vector &origin, const Vector &ray,
+                                  const WorldBounds &bounds, double *tEnter)
+        {
+            if(!bounds.bounded)
+            {
+                *tEnter = 0.0;
+                return true;
+            }
+            if(bounds.empty)
+            {
+                return false;
+            }
+
+            double t0 = 0.0, t1 = 1.0;
+            for(int axis = 0; axis < 3; ++axis)
+            {
+                if(std::fabs(ray[axis]) < 1e-12)
+                {
+                    if(origin[axis] < bounds.min[axis] || origin[axis] > bounds.max[axis])
+                    {
+                        return false;
+                    }
+                    continue;
+                }
+                const double inv = 1.0 / ray[axis];
+                double tNear = (bounds.min[axis] - origin[axis]) * inv;
+                double tFar = (bounds.max[axis] - origin[axis]) * inv;
+                if(tNear > tFar)
+                {
+                    std::swap(tNear, tFar);
+                }
+                t0 = std::max(t0, tNear);
+                t1 = std::min(t1, tFar);
+                if(t0 > t1)
+                {
+                    return false;
+                }
+            }
+            *tEnter = t0;
+            return true;
+        }
+
+        // squared distance of a point to the bounds, used to order the subworlds
+        static double boundsDistance2(const Vector &point, const WorldBounds &bounds)
+        {
+            if(!bounds.bounded || bounds.empty)
+            {
+                return 0.0;
+            }
+            const Vector clamped = point.cwiseMax(bounds.min).cwiseMin(bounds.max);
+            return (point - clamped).squaredNorm();
+        }
+
         Simulator::Simulator(lib_manager::LibManager *theManager) :
             lib_manager::LibInterface{theManager},
             exit_sim{false}, allow_draw{true},
@@ -125,10 +188,20 @@ namespace mars
             // control a clean exit from the thread
             kill_sim = 0;
             sim_fault = false;
+            batch_steps = 0;
+            batch_load_failed = false;
+            batch_finished = false;
+            batch_status = BATCH_OK;
+            profiling_files_written = false;
+            nextCheckpointId = 1;
+            startedFromCheckpoint = false;
+            fast_reset = false;
             // set the calculation step size in ms
             calc_ms      = 10; //defaultCFG->getInt("physics", "calc_ms", 10);
             avg_count_steps = 20;
             my_real_time = 0;
+            parallel_rays = false;
+            bounds_margin = 0.25;
             // to synchronise drawing and physics
             sync_time = 40;
             sync_count = 0;
@@ -164,6 +237,22 @@ namespace mars
             //GraphEventDispatcher::subscribe(control->envireGraph_.get());
 
             absolutePoseExtender = std::unique_ptr<AbsolutePoseExtender>{new AbsolutePoseExtender{control->envireGraph_}};
+            posePropagator = std::unique_ptr<PosePropagator>{new PosePropagator{control->envireGraph_, control->graphTreeView_}};
+            subWorldBounds = std::unique_ptr<SubWorldBounds>{new SubWorldBounds{control->envireGraph_, control->graphTreeView_}};
+
+            // the subworlds are stepped in parallel by a pool sized to the hardware concurrency
+            stepPool = std::unique_ptr<ThreadPool>{new ThreadPool{}};
+            rayPool = std::unique_ptr<ThreadPool>{new ThreadPool{}};
+
+            stepProfiler = std::unique_ptr<StepProfiler>{new StepProfiler{}};
+            profilePhases.step = stepProfiler->addPhase("step");
+            profilePhases.prePhysicsUpdate = stepProfiler->addPhase("prePhysicsUpdate");
+            profilePhases.clearPreviousStep = stepProfiler->addPhase("clearPreviousStep");
+            profilePhases.handleContacts = stepProfiler->addPhase("handleContacts");
+            profilePhases.subWorldStep = stepProfiler->addPhase("subWorldStep");
+            profilePhases.subWorldBounds = stepProfiler->addPhase("subWorldBounds");
+            profilePhases.updateMotors = stepProfiler->addPhase("updateMotors");
+            profilePhases.dataBroker = stepProfiler->addPhase("dataBroker");
 
             // build the factories
             ControlCenter::loadCenter = new LoadCenter{};
@@ -199,15 +288,6 @@ namespace mars
 
         Simulator::~Simulator()
         {
-            for(auto &it: subWorlds)
-            {
-                it.second->stopThread = true;
-                while(it.second->isRunning())
-                {
-                    utils::msleep(1);
-                }
-            }
-
             {
                 const auto* const simThread{dynamic_cast<Thread*>(this)};
                 while(simThread->isRunning())
@@ -217,6 +297,8 @@ namespace mars
             }
             fprintf(stderr, "Delete mars_sim\n");
 
+            writeProfilingFiles();
+
             if(control->cfg)
             {
                 auto saveFile = configPath.sValue;
@@ -248,6 +330,34 @@ namespace mars
             //libManager->releaseLibrary("log_console");
         }
 
+        void Simulator::writeProfilingFiles()
+        {
+            // a batch run writes them when it finished, the destructor again
+            if(profiling_files_written)
+            {
+                return;
+            }
+            profiling_files_written = true;
+            if(control->cfg && !cfgTraceFile.sValue.empty())
+            {
+                Tracer::stop();
+                if(!Tracer::write(cfgTraceFile.sValue))
+                {
+                    LOG_ERROR("Simulator: could not write trace to %s",
+                              cfgTraceFile.sValue.c_str());
+                }
+            }
+
+            if(control->cfg && !cfgProfileFile.sValue.empty())
+            {
+                if(!writeStepProfile(cfgProfileFile.sValue))
+                {
+                    LOG_ERROR("Simulator: could not write step profile to %s",
+                              cfgProfileFile.sValue.c_str());
+                }
+            }
+        }
+
         void Simulator::newLibLoaded(const std::string &libName)
         {
             checkOptionalDependency(libName);
@@ -292,6 +402,10 @@ namespace mars
                                                                 dbSimDebugPackage,
                                                                 nullptr,
                                                                 data_broker::DATA_PACKAGE_READ_FLAG);
+                dbSubWorldTimeId = ControlCenter::theDataBroker->pushData("mars_sim", "subWorldTime",
+                                                                dbSubWorldTimePackage,
+                                                                nullptr,
+                                                                data_broker::DATA_PACKAGE_READ_FLAG);
                 getTimeMutex.unlock();
                 ControlCenter::theDataBroker->createTimer("mars_sim/simTimer");
                 ControlCenter::theDataBroker->createTrigger("mars_sim/prePhysicsUpdate");
@@ -355,7 +469,7 @@ namespace mars
         {
             ControlCenter::motors = std::make_shared<MotorManager>(control.get());
             ControlCenter::joints = std::make_shared<JointManager>(control.get());
-            ControlCenter::sensors = std::make_shared<SensorManager>(control.get());
+            ControlCenter::sensors = std::make_shared<SensorManager>(control.get(), this);
             ControlCenter::nodes = new NodeManager{control.get(), libManager};
         }
 
@@ -377,6 +491,11 @@ namespace mars
         void Simulator::setupCollisions()
         {
             collisionManager = std::unique_ptr<CollisionManager>{new CollisionManager{control}};
+            // not registered as concurrent: the ODE handler collides through
+            // the ODE spaces of the items, so only pairs without a common
+            // space are generated at the same time. Its ray queries are not
+            // declared concurrent with setConcurrentRayQueries(), concurrent
+            // getVectorCollision() calls on one space are not verified.
             collisionManager->addCollisionHandler("mars_ode_collision", "mars_ode_collision", std::make_shared<ode_collision::CollisionHandler>());
             collisionSpaceLoader = libManager->getLibraryAs<ode_collision::CollisionSpaceLoader>("mars_ode_collision", true);
             if(collisionSpaceLoader)
@@ -460,9 +579,24 @@ namespace mars
             {
                 LOG_INFO("Simulator: scene to load: %s",
                          arg_v_scene_name.back().c_str());
-                loadScene(arg_v_scene_name.back());
+                // the scene loaders do not all fail on a missing file
+                if(!pathExists(arg_v_scene_name.back()) || !loadScene(arg_v_scene_name.back()))
+                {
+                    batch_load_failed = true;
+                }
                 arg_v_scene_name.pop_back();
             }
+            if(!startCheckpointFile.empty())
+            {
+                if(loadCheckpointFile(startCheckpointFile))
+                {
+                    startedFromCheckpoint = true;
+                }
+                else
+                {
+                    batch_load_failed = true;
+                }
+            }
             if (arg_run)
             {
                 simulationStatus = RUNNING;
@@ -471,12 +605,108 @@ namespace mars
                 simRealTime = 0;
             }
 
-            if(startThread)
+            // a batch run steps in this thread
+            if(startThread && !batch_steps)
             {
                 this->start();
             }
 
             collisionSpace->updateTransforms();
+
+            if(batch_steps)
+            {
+                // a batch run has no interactive loop, the host application
+                // exits with the status once runSimulation() returned
+                BatchStatus status = BATCH_LOAD_FAILED;
+                if(batch_load_failed)
+                {
+                    LOG_ERROR("Simulator: batch run aborted, a scene or the checkpoint could not be loaded");
+                }
+                else
+                {
+                    status = runBatch(batch_steps);
+                }
+                writeProfilingFiles();
+                batch_status = status;
+                batch_finished = true;
+            }
+        }
+
+        bool Simulator::isBatchRunFinished() const
+        {
+            return batch_finished;
+        }
+
+        Simulator::BatchStatus Simulator::getBatchStatus() const
+        {
+            return batch_status;
+        }
+
+        Simulator::BatchStatus Simulator::runBatch(unsigned long steps)
+        {
+            // plugins added while loading the scene are activated here
+            finishedDraw();
+
+            stepping_mutex.lock();
+            my_real_time = false;
+            sync_graphics = false;
+            simulationStatus = RUNNING;
+            simStartTime = dbSimTimePackage[0].d;
+            simRealTime = 0;
+            stepping_mutex.unlock();
+
+            resetStepProfile();
+            const uint64_t start = StepProfiler::now();
+            unsigned long done = 0;
+            // the poses of the AbsolutePose items and static child frames are
+            // propagated as often as the graphics would be synchronized
+            const unsigned long propagateSteps = calc_ms > 0 ? std::max(1UL, static_cast<unsigned long>(sync_time / calc_ms)) : 1UL;
+            // kill_sim is set on a physics error with "onPhysicsError" set to "shutdown"
+            while(done < steps && !kill_sim)
+            {
+                step();
+                ++done;
+                if(done % propagateSteps == 0)
+                {
+                    propagatePoses();
+                }
+            }
+            const double wallTime = (StepProfiler::now() - start)*1e-9;
+            // the graph holds the final poses when the stats are written
+            propagatePoses();
+            const double simTime = done*calc_ms*1e-3;
+            simulationStatus = STOPPED;
+
+            BatchStatus status = sim_fault ? BATCH_SIM_FAULT : BATCH_OK;
+            LOG_INFO("Simulator: batch run of %lu/%lu steps in %.3f s, %.1f steps/s, %.1fx realtime",
+                     done, steps, wallTime, wallTime > 0 ? done/wallTime : 0.0,
+                     wallTime > 0 ? simTime/wallTime : 0.0);
+
+            if(!batch_stats_file.empty())
+            {
+                FILE *file = fopen(batch_stats_file.c_str(), "w");
+                if(file)
+                {
+                    fprintf(file, "# steps %lu of %lu\n", done, steps);
+                    fprintf(file, "# wall_time_s %.6f\n", wallTime);
+                    fprintf(file, "# sim_time_s %.6f\n", simTime);
+                    fprintf(file, "# steps_per_s %.3f\n", wallTime > 0 ? done/wallTime : 0.0);
+                    fprintf(file, "# realtime_factor %.3f\n", wallTime > 0 ? simTime/wallTime : 0.0);
+                    fprintf(file, "# status %d\n", static_cast<int>(status));
+                    stepProfiler->writeStatistics(file);
+                    fclose(file);
+                }
+                else
+                {
+                    LOG_ERROR("Simulator: could not write batch stats to %s",
+                              batch_stats_file.c_str());
+                    if(status == BATCH_OK)
+                    {
+                        status = BATCH_STATS_FAILED;
+                    }
+                }
+            }
+            return status;
         }
 
         std::shared_ptr<SubControlCenter> Simulator::createSubWorld(const std::string &name)
@@ -546,6 +776,7 @@ namespace mars
          */
         void Simulator::run()
         {
+            Tracer::setThreadName("mars_sim");
 
             while (!kill_sim)
             {
@@ -557,6 +788,7 @@ namespace mars
 
                 if(!isSimRunning())
                 {
+                    TraceScope trace{"Simulator::waitForStart"};
                     stepping_wc.wait(&stepping_mutex);
                     if(kill_sim)
                     {
@@ -567,6 +799,7 @@ namespace mars
 
                 if (sync_graphics && !sync_count)
                 {
+                    TraceScope trace{"Simulator::waitForGraphics"};
                     msleep(2);
                     stepping_mutex.unlock();
                     continue;
@@ -578,21 +811,24 @@ namespace mars
                 }
                 stepping_mutex.unlock();
 
-                if(my_real_time)
-                {
-                    myRealTime();
-                }
-                else if(physics_mutex_count > 0)
                 {
-                    myRealTime();
-                    // if not in realtime this thread would lock the physicsThread right
-                    // after releasing it. If an other thread is trying to lock
-                    // it (physics_mutex_count > 0) we sleep so it has a chance.
-                    msleep(1);
-                }
-                else
-                {
-                    myRealTime();
+                    TraceScope trace{"Simulator::myRealTime"};
+                    if(my_real_time)
+                    {
+                        myRealTime();
+                    }
+                    else if(physics_mutex_count > 0)
+                    {
+                        myRealTime();
+                        // if not in realtime this thread would lock the physicsThread right
+                        // after releasing it. If an other thread is trying to lock
+                        // it (physics_mutex_count > 0) we sleep so it has a chance.
+                        msleep(1);
+                    }
+                    else
+                    {
+                        myRealTime();
+                    }
                 }
                 step();
             }
@@ -604,11 +840,12 @@ namespace mars
         {
             auto oldState = Status::UNKNOWN;
             long time = 0;
-            struct timeval tv;
-            tv.tv_sec = 0;
-            tv.tv_usec = 10L;
 
             physicsThreadLock();
+            TraceScope trace{"Simulator::step"};
+
+            const uint64_t stepStart = StepProfiler::now();
+            uint64_t phaseStart = stepStart;
 
             if(setState)
             {
@@ -622,12 +859,15 @@ namespace mars
             {
                 ControlCenter::theDataBroker->trigger("mars_sim/prePhysicsUpdate");
             }
+            phaseStart = recordPhase(profilePhases.prePhysicsUpdate, phaseStart);
 
             for(auto &it: subWorlds)
             {
                 it.second->control->physics->clearPreviousStep();
             }
+            phaseStart = recordPhase(profilePhases.clearPreviousStep, phaseStart);
             collisionManager->handleContacts();
+            phaseStart = recordPhase(profilePhases.handleContacts, phaseStart);
 
             contactLinesDataMutex.lock();
             contactLinesData.clear();
@@ -652,25 +892,17 @@ namespace mars
             }
             contactLinesDataMutex.unlock();
 
-            for(const auto &it: subWorlds)
-            {
-                it.second->calcStep = true;
-                // while(it.second->calcStep == true) {
-                //     select(0, 0, 0, 0, &tv);
-                // }
-            }
-            for(const auto &it: subWorlds)
-            {
-                while(it.second->calcStep == true)
-                {
-                    select(0, 0, 0, 0, &tv);
-                }
-            }
+            phaseStart = StepProfiler::now();
+            stepPool->parallelFor(subWorldList.size(), [this](size_t i) { subWorldList[i]->step(); });
+            phaseStart = recordPhase(profilePhases.subWorldStep, phaseStart);
+            updateSubWorldBounds();
+            phaseStart = recordPhase(profilePhases.subWorldBounds, phaseStart);
 
             avg_step_time += static_cast<double>(getTimeDiff(time));
 
             // control->joints->updateJoints(calc_ms);
             control->motors->updateMotors(calc_ms);
+            phaseStart = recordPhase(profilePhases.updateMotors, phaseStart);
 
             time = utils::getTime();
 
@@ -682,6 +914,8 @@ namespace mars
                 ControlCenter::theDataBroker->pushData(dbSimTimeId, dbSimTimePackage);
                 ControlCenter::theDataBroker->stepTimer("mars_sim/simTimer", calc_ms);
             }
+            // includes the sensors triggered by the sim timer
+            recordPhase(profilePhases.dataBroker, phaseStart);
 
             avg_log_time += static_cast<double>(getTimeDiff(time));
             if(++count > avg_count_steps)
@@ -692,6 +926,19 @@ namespace mars
                 dbSimDebugPackage[1].d = avg_step_time;
                 dbSimDebugPackage[2].d = avg_log_time;
                 avg_step_time = avg_log_time = 0.0;
+
+                // per world share of the physics step to see which world dominates a frame
+                getTimeMutex.lock();
+                for(size_t i = 0; i < subWorldList.size(); ++i)
+                {
+                    dbSubWorldTimePackage[i].d = subWorldList[i]->takeAvgStepTime();
+                }
+                getTimeMutex.unlock();
+                if(ControlCenter::theDataBroker)
+                {
+                    ControlCenter::theDataBroker->pushData(dbSubWorldTimeId,
+                                                           dbSubWorldTimePackage);
+                }
             }
             pluginLocker.lockForRead();
 
@@ -702,9 +949,19 @@ namespace mars
             {
                 erased_active = false;
                 time = utils::getTime();
+                // the plugin might be erased from activePlugins during its update
+                auto pluginPhase = pluginPhases.find(activePlugins[i].p_interface);
+                if(pluginPhase == pluginPhases.end())
+                {
+                    pluginPhase = pluginPhases.emplace(activePlugins[i].p_interface,
+                                                       stepProfiler->addPhase("plugin/" + activePlugins[i].name)).first;
+                }
+                phaseStart = StepProfiler::now();
 
                 activePlugins[i].p_interface->update(calc_ms);
 
+                recordPhase(pluginPhase->second, phaseStart);
+
                 if(!erased_active)
                 {
                     time = getTimeDiff(time);
@@ -749,6 +1006,8 @@ namespace mars
                 ControlCenter::theDataBroker->trigger("mars_sim/postPhysicsUpdate");
             }
 
+            recordPhase(profilePhases.step, stepStart);
+
             if(setState)
             {
                 simulationStatus = oldState;
@@ -759,15 +1018,19 @@ namespace mars
 
         void Simulator::StartSimulation()
         {
-            auto wheelJoints = std::vector<std::string>{"artemisfront_left", "artemisfront_right", "artemismiddle_left", "artemismiddle_right", "artemisrear_left", "artemisrear_right"};
-            constexpr auto seed = 40;
-            srand(seed);
-            for (auto wheel_joint : wheelJoints)
+            // the checkpoint already holds the settled wheels
+            if(!startedFromCheckpoint)
             {
-                auto id = control->joints->getID(wheel_joint);
-                auto randomrad = static_cast<double>(rand() % 360) / M_PI_2;
-                std::cout << "Setting value for joint " << wheel_joint << " to " << randomrad << std::endl;
-                control->joints->setOfflineValue(id, randomrad);
+                auto wheelJoints = std::vector<std::string>{"artemisfront_left", "artemisfront_right", "artemismiddle_left", "artemismiddle_right", "artemisrear_left", "artemisrear_right"};
+                constexpr auto seed = 40;
+                srand(seed);
+                for (auto wheel_joint : wheelJoints)
+                {
+                    auto id = control->joints->getID(wheel_joint);
+                    auto randomrad = static_cast<double>(rand() % 360) / M_PI_2;
+                    std::cout << "Setting value for joint " << wheel_joint << " to " << randomrad << std::endl;
+                    control->joints->setOfflineValue(id, randomrad);
+                }
             }
 
             fprintf(stderr, "Simulation started ....\n");
@@ -1122,6 +1385,7 @@ namespace mars
 
         void Simulator::finishedDraw(void)
         {
+            TraceScope trace{"Simulator::finishedDraw"};
             processRequests();
 
             if (reloadSim)
@@ -1225,13 +1489,19 @@ namespace mars
                     ". The physics plugin cannot handle loops in the graph";
                 throw std::runtime_error(msg);
             }
-            // update the graph from top to bottom
-            // starts with the parent and go to children
-            const VertexDesc originDesc = control->envireGraph_->vertex(SIM_CENTER_FRAME_NAME);
+            propagatePoses();
+        }
 
+        void Simulator::propagatePoses()
+        {
+            // The physics, controller and sensor threads read the graph while
+            // holding the physics lock, so the transforms and AbsolutePose
+            // items are only written with the physics blocked.
             physicsThreadLock();
-            Simulator::updateChildPositions(originDesc, base::TransformWithCovariance::Identity(),
-                                            control->envireGraph_, control->graphTreeView_);
+            posePropagator->updatePlan();
+            // update the graph from top to bottom, only the subtrees of
+            // dynamic objects that moved since the last draw are visited
+            posePropagator->update();
             physicsThreadUnlock();
         }
 
@@ -1489,6 +1759,13 @@ namespace mars
 
         void Simulator::resetSim(bool resetGraphics)
         {
+            // the reset scene is not settled anymore
+            startedFromCheckpoint = false;
+            if(fast_reset)
+            {
+                resetInPlace();
+                return;
+            }
             reloadSim = true;
             reloadGraphics = resetGraphics;
             stepping_mutex.lock();
@@ -1562,6 +1839,9 @@ namespace mars
                 {"scenename", 1, 0, 's'},
                 {"config_dir", required_argument, 0, 'C'},
                 {"c_port",1,0,'c'},
+                {"batch", required_argument, 0, 'b'},
+                {"batch_stats", required_argument, 0, 'S'},
+                {"checkpoint", required_argument, 0, 'k'},
                 {0, 0, 0, 0}
             };
 
@@ -1592,7 +1872,7 @@ namespace mars
 
             while (1)
             {
-                c = getopt_long(argc, argv, "hrgoGs:C:p:", long_options, &option_index);
+                c = getopt_long(argc, argv, "hrgoGs:C:p:b:S:k:", long_options, &option_index);
                 if (c == -1)
                     break;
                 switch (c)
@@ -1603,11 +1883,9 @@ namespace mars
                     tmp_v_s = explodeString(';', optarg);
                     for(size_t i = 0; i < tmp_v_s.size(); ++i)
                     {
-                        if(pathExists(tmp_v_s[i]))
-                        {
-                            arg_v_scene_name.push_back(tmp_v_s[i]);
-                        }
-                        else
+                        // kept even if missing, so loading it fails and a batch run aborts
+                        arg_v_scene_name.push_back(tmp_v_s[i]);
+                        if(!pathExists(tmp_v_s[i]))
                         {
                             LOG_ERROR("The given scene file does not exists: %s\n",
                                       tmp_v_s[i].c_str());
@@ -1633,6 +1911,17 @@ namespace mars
                     break;
                 case 'G':
                     break;
+                case 'b':
+                    batch_steps = strtoul(optarg, nullptr, 10);
+                    break;
+                case 'S':
+                    batch_stats_file = optarg;
+                    break;
+                case 'k':
+                    // kept even if missing, so loading it fails and a batch run aborts
+                    startCheckpointFile = optarg;
+                    if(!pathExists(optarg)) LOG_ERROR("The given checkpoint file does not exists: %s\n", optarg);
+                    break;
                 case 'h':
                 default:
                     printf("\naccepted parameters are:\n");
@@ -1644,6 +1933,9 @@ namespace mars
                     printf("-C             path to Configuration\n");
                     printf("-g             show 3d grid\n");
                     printf("-o             ortho perspective as standard\n");
+                    printf("-b <steps>     headless batch run of the given steps, exits afterwards\n");
+                    printf("-S <filename>  write the stats of a batch run to this file\n");
+                    printf("-k <filename>  restore the checkpoint after loading the scenes\n");
                     printf("\n");
                 }
             }
@@ -1658,6 +1950,7 @@ namespace mars
             physicsCountMutex.lock();
             physics_mutex_count++;
             physicsCountMutex.unlock();
+            TraceScope trace{"Simulator::physicsThreadLock"};
             physicsMutex.lock();
         }
 
@@ -2194,6 +2487,79 @@ namespace mars
                 return;
             }
 
+            // the collision pairs and the pool are read by the stepping thread
+            if(_property.paramId == cfgCollisionBroadphase.paramId)
+            {
+                physicsThreadLock();
+                collisionManager->setBroadphase(_property.bValue);
+                physicsThreadUnlock();
+                return;
+            }
+
+            if(_property.paramId == cfgParallelContacts.paramId)
+            {
+                physicsThreadLock();
+                collisionManager->setThreadPool(_property.bValue ? stepPool.get() : nullptr);
+                physicsThreadUnlock();
+                return;
+            }
+
+            if(_property.paramId == cfgParallelRays.paramId)
+            {
+                parallel_rays = _property.bValue;
+                return;
+            }
+
+            if(_property.paramId == cfgBoundsMargin.paramId)
+            {
+                bounds_margin = _property.dValue;
+                return;
+            }
+
+            if(_property.paramId == cfgProfileFile.paramId)
+            {
+                cfgProfileFile.sValue = _property.sValue;
+                return;
+            }
+
+            if(_property.paramId == cfgBatchSteps.paramId)
+            {
+                batch_steps = std::max(0, _property.iValue);
+                return;
+            }
+
+            if(_property.paramId == cfgBatchStatsFile.paramId)
+            {
+                batch_stats_file = _property.sValue;
+                return;
+            }
+
+            if(_property.paramId == cfgFastReset.paramId)
+            {
+                fast_reset = _property.bValue;
+                return;
+            }
+
+            if(_property.paramId == cfgCheckpointFile.paramId)
+            {
+                startCheckpointFile = _property.sValue;
+                return;
+            }
+
+            if(_property.paramId == cfgTraceFile.paramId)
+            {
+                cfgTraceFile.sValue = _property.sValue;
+                if(cfgTraceFile.sValue.empty())
+                {
+                    Tracer::stop();
+                }
+                else
+                {
+                    Tracer::start();
+                }
+                return;
+            }
+
         }
 
         void Simulator::initCfgParams(void)
@@ -2245,6 +2611,50 @@ namespace mars
             cfgAvgCountSteps = control->cfg->getOrCreateProperty("Simulator", "avg count steps",
                                                                  avg_count_steps, this);
             avg_count_steps = cfgAvgCountSteps.iValue;
+            // only takes effect if the collision plugins allow concurrent ray queries
+            cfgParallelRays = control->cfg->getOrCreateProperty("Simulator", "parallel ray sensors",
+                                                                false, this);
+            parallel_rays = cfgParallelRays.bValue;
+            // runs the collision pairs without a common collision space in parallel
+            cfgParallelContacts = control->cfg->getOrCreateProperty("Simulator", "parallel contacts",
+                                                                    false, this);
+            collisionManager->setThreadPool(cfgParallelContacts.bValue ? stepPool.get() : nullptr);
+            // culls the pairs of subworlds by their bounds, which enclose the
+            // geometries plus the "ray bounds margin"
+            cfgCollisionBroadphase = control->cfg->getOrCreateProperty("Simulator", "collision broadphase",
+                                                                       false, this);
+            collisionManager->setBroadphase(cfgCollisionBroadphase.bValue);
+            // the margin covers the motion of the bodies between two updates of
+            // the bounds, a negative margin disables the culling of subworlds
+            cfgBoundsMargin = control->cfg->getOrCreateProperty("Simulator", "ray bounds margin",
+                                                                bounds_margin, this);
+            bounds_margin = cfgBoundsMargin.dValue;
+            // the step profile is written to this file on exit if it is set
+            cfgProfileFile = control->cfg->getOrCreateProperty("Simulator", "profile file",
+                                                               "", this);
+            // tracing is enabled while a trace file is set, the trace is written on exit
+            cfgTraceFile = control->cfg->getOrCreateProperty("Simulator", "trace file",
+                                                             "", this);
+            if(!cfgTraceFile.sValue.empty())
+            {
+                Tracer::start();
+            }
+            // a batch run is started by runSimulation() if the steps are set,
+            // the command line options --batch and --batch_stats override these
+            cfgBatchSteps = control->cfg->getOrCreateProperty("Simulator", "batch steps",
+                                                              (int)0, this);
+            batch_steps = std::max(0, cfgBatchSteps.iValue);
+            cfgBatchStatsFile = control->cfg->getOrCreateProperty("Simulator", "batch stats file",
+                                                                  "", this);
+            batch_stats_file = cfgBatchStatsFile.sValue;
+            // resetSim() moves the bodies back instead of reloading the world
+            cfgFastReset = control->cfg->getOrCreateProperty("Simulator", "fast reset",
+                                                             false, this);
+            fast_reset = cfgFastReset.bValue;
+            // restored after the scenes are loaded on startup, see saveCheckpointFile()
+            cfgCheckpointFile = control->cfg->getOrCreateProperty("Simulator", "checkpoint file",
+                                                                  "", this);
+            startCheckpointFile = cfgCheckpointFile.sValue;
             control->cfg->getOrCreateProperty("Simulator", "onPhysicsError",
                                               "abort", this);
 
@@ -2413,7 +2823,11 @@ namespace mars
 
             //world->control->physics->draw_contact_points = cfgDrawContact.bValue;
             subWorlds[subWorld->control->getPrefix()] = std::unique_ptr<SubWorld>(subWorld);
-            subWorld->start();
+            subWorld->vertex = control->envireGraph_->getVertex(e.frame);
+            subWorldList.push_back(subWorld);
+            getTimeMutex.lock();
+            dbSubWorldTimePackage.add(subWorld->control->getPrefix(), 0.0);
+            getTimeMutex.unlock();
 
             // store the control center of the subworld in its own frame in the graph
             using SubControlItem = envire::core::Item<std::shared_ptr<interfaces::SubControlCenter>>;
@@ -2434,36 +2848,50 @@ namespace mars
             envire::core::GraphDrawing::write(*(control->envireGraph_.get()), fileName);
         }
 
-        void Simulator::resetPoses()
+        /**
+         * Resets the AbsolutePose of node to its initial pose and adapts the
+         * transform from parent to node. The parent has to be reset before.
+         * Returns the reset pose or nullptr if the frame has no AbsolutePose.
+         */
+        static AbsolutePose* resetFramePose(envire::core::EnvireGraph *graph, VertexDesc node, VertexDesc parent)
         {
-            auto* const c = control.get();
-            auto resetPoseFunctor = [c](VertexDesc node, VertexDesc parent)
+            // TODO: This has implicit assumptions which are not enforced nor documented!
+            //  * Root frame is assumed to not have an AbsolutePose.
+            //  * Root frame is located at (0,0,0) with (1,0,0,0) rotation
+            //  * Each other frame has exactly one Item of type AbsolutePose
+
+            using AbsolutePoseEnvireItem = envire::core::Item<AbsolutePose>;
+            if (!graph->containsItems<AbsolutePoseEnvireItem>(node))
             {
-                // TODO: This has implicit assumptions which are not enforced nor documented!
-                //  * Root frame is assumed to not have an AbsolutePose.
-                //  * Root frame is located at (0,0,0) with (1,0,0,0) rotation
-                //  * Each other frame has exactly one Item of type AbsolutePose
+                return nullptr;
+            }
 
-                using AbsolutePoseEnvireItem = envire::core::Item<AbsolutePose>;
-                if (c->envireGraph_->containsItems<AbsolutePoseEnvireItem>(node))
-                {
-                    // Calculate where node should be after potential change of parents position.
-                    const auto parentAbsolutePose = c->envireGraph_->containsItems<AbsolutePoseEnvireItem>(parent) ? c->envireGraph_->getItem<AbsolutePoseEnvireItem>(parent)->getData() : AbsolutePose{};
-                    const auto& transformation = c->envireGraph_->getTransform(parent, node);
-                    const auto parentTransform = envire::core::Transform{parentAbsolutePose.getPosition(), parentAbsolutePose.getRotation()};
-                    const auto rootToNode = parentTransform * transformation;
+            // Calculate where node should be after potential change of parents position.
+            const auto parentAbsolutePose = graph->containsItems<AbsolutePoseEnvireItem>(parent) ? graph->getItem<AbsolutePoseEnvireItem>(parent)->getData() : AbsolutePose{};
+            const auto& transformation = graph->getTransform(parent, node);
+            const auto parentTransform = envire::core::Transform{parentAbsolutePose.getPosition(), parentAbsolutePose.getRotation()};
+            const auto rootToNode = parentTransform * transformation;
 
-                    // Set where node should be after the reset of parent.
-                    auto& currentAbsolutePose = c->envireGraph_->getItem<AbsolutePoseEnvireItem>(node)->getData();
-                    currentAbsolutePose.setPosition(rootToNode.transform.translation);
-                    currentAbsolutePose.setRotation(rootToNode.transform.orientation);
+            // Set where node should be after the reset of parent.
+            auto& currentAbsolutePose = graph->getItem<AbsolutePoseEnvireItem>(node)->getData();
+            currentAbsolutePose.setPosition(rootToNode.transform.translation);
+            currentAbsolutePose.setRotation(rootToNode.transform.orientation);
 
-                    // Reset the position of node to the initial pose.
-                    const auto transformationChange = envire::core::Transform{currentAbsolutePose.resetPose()};
+            // Reset the position of node to the initial pose.
+            const auto transformationChange = envire::core::Transform{currentAbsolutePose.resetPose()};
 
-                    // Adapt the transformation from parent to node to reflect the reset pose of node.
-                    c->envireGraph_->setEdgeProperty(parent, node, transformation * transformationChange);
+            // Adapt the transformation from parent to node to reflect the reset pose of node.
+            graph->setEdgeProperty(parent, node, transformation * transformationChange);
+            return &currentAbsolutePose;
+        }
 
+        void Simulator::resetPoses()
+        {
+            auto* const c = control.get();
+            auto resetPoseFunctor = [c](VertexDesc node, VertexDesc parent)
+            {
+                if (resetFramePose(c->envireGraph_.get(), node, parent))
+                {
                     // Also remove potential dynamicobject from node.
                     itemRemover<interfaces::DynamicObjectItem>(c->envireGraph_.get(), node);
                 }
@@ -2517,6 +2945,267 @@ namespace mars
 #endif
         }
 
+        void Simulator::resetInPlace()
+        {
+            using DynamicObjectEnvireItem = envire::core::Item<DynamicObjectItem>;
+            auto* const graph = control->envireGraph_.get();
+            // moves the existing dynamic objects to the reset poses instead
+            // of recreating them like resetPoses() and reloadObjects()
+            auto teleportFunctor = [graph](VertexDesc node, VertexDesc parent)
+            {
+                const auto* const absolutePose = resetFramePose(graph, node, parent);
+                if(absolutePose && graph->containsItems<DynamicObjectEnvireItem>(node))
+                {
+                    const auto& dynamicObject = graph->getItem<DynamicObjectEnvireItem>(node)->getData().dynamicObject;
+                    dynamicObject->setPosition(absolutePose->getPosition());
+                    dynamicObject->setRotation(absolutePose->getRotation());
+                    dynamicObject->setLinearVelocity(utils::Vector::Zero());
+                    dynamicObject->setAngularVelocity(utils::Vector::Zero());
+                }
+            };
+
+            physicsThreadLock();
+            const auto& rootVertex = graph->getVertex(SIM_CENTER_FRAME_NAME);
+            control->graphTreeView_->visitDfs(rootVertex, teleportFunctor);
+            dynamic_cast<MotorManager*>(control->motors.get())->resetMotors();
+
+            realStartTime = utils::getTime();
+            getTimeMutex.lock();
+            dbSimTimePackage[0].set(0.);
+            getTimeMutex.unlock();
+            simStartTime = 0;
+            simRealTime = 0;
+
+            posePropagator->invalidate();
+
+            // the next step has to see the plugins reset together with the
+            // bodies, so like in their update() the physics is blocked
+            pluginLocker.lockForRead();
+            for(auto &plugin: allPlugins)
+            {
+                plugin.p_interface->reset();
+            }
+            pluginLocker.unlock();
+
+            physicsThreadUnlock();
+        }
+
+        unsigned long Simulator::saveCheckpoint()
+        {
+            SimulationCheckpoint checkpoint;
+            physicsThreadLock();
+            captureCheckpoint(&checkpoint);
+            physicsThreadUnlock();
+
+            checkpointMutex.lock();
+            const unsigned long id = nextCheckpointId++;
+            checkpoints[id] = std::move(checkpoint);
+            checkpointMutex.unlock();
+            return id;
+        }
+
+        bool Simulator::restoreCheckpoint(unsigned long id)
+        {
+            checkpointMutex.lock();
+            const auto it = checkpoints.find(id);
+            if(it == checkpoints.end())
+            {
+                checkpointMutex.unlock();
+                LOG_ERROR("Simulator: there is no checkpoint with id %lu", id);
+                return false;
+            }
+            physicsThreadLock();
+            const bool restored = applyCheckpoint(it->second);
+            physicsThreadUnlock();
+            checkpointMutex.unlock();
+            return restored;
+        }
+
+        void Simulator::removeCheckpoint(unsigned long id)
+        {
+            checkpointMutex.lock();
+            checkpoints.erase(id);
+            checkpointMutex.unlock();
+        }
+
+        bool Simulator::saveCheckpointFile(const std::string &filename)
+        {
+            SimulationCheckpoint checkpoint;
+            physicsThreadLock();
+            captureCheckpoint(&checkpoint);
+            physicsThreadUnlock();
+
+            if(!writeCheckpoint(checkpoint, filename))
+            {
+                LOG_ERROR("Simulator: could not write checkpoint to %s", filename.c_str());
+                return false;
+            }
+            return true;
+        }
+
+        bool Simulator::loadCheckpointFile(const std::string &filename)
+        {
+            SimulationCheckpoint checkpoint;
+            if(!readCheckpoint(filename, &checkpoint))
+            {
+                LOG_ERROR("Simulator: could not read checkpoint from %s", filename.c_str());
+                return false;
+            }
+            physicsThreadLock();
+            const bool restored = applyCheckpoint(checkpoint);
+            physicsThreadUnlock();
+            return restored;
+        }
+
+        void Simulator::captureCheckpoint(SimulationCheckpoint *checkpoint)
+        {
+            using DynamicObjectEnvireItem = envire::core::Item<DynamicObjectItem>;
+            auto* const graph = control->envireGraph_.get();
+
+            checkpoint->bodies.clear();
+            const auto& rootVertex = graph->getVertex(SIM_CENTER_FRAME_NAME);
+            control->graphTreeView_->visitDfs(rootVertex, [graph, checkpoint](VertexDesc node, VertexDesc parent)
+            {
+                if(!graph->containsItems<DynamicObjectEnvireItem>(node))
+                {
+                    return;
+                }
+                const auto& dynamicObject = graph->getItem<DynamicObjectEnvireItem>(node)->getData().dynamicObject;
+                SimulationCheckpoint::BodyState body;
+                body.frame = graph->getFrameId(node);
+                dynamicObject->getPosition(&body.position);
+                dynamicObject->getRotation(&body.rotation);
+                dynamicObject->getLinearVelocity(&body.linearVelocity);
+                dynamicObject->getAngularVelocity(&body.angularVelocity);
+                checkpoint->bodies.push_back(body);
+            });
+
+            checkpoint->joints.clear();
+            for(const auto& joint: dynamic_cast<JointManager*>(control->joints.get())->getSimJoints())
+            {
+                core_objects_exchange jointExchange;
+                joint->getCoreExchange(&jointExchange);
+                checkpoint->joints.push_back({jointExchange.name, joint->getPosition(), joint->getVelocity()});
+            }
+
+            checkpoint->motors.clear();
+            std::vector<core_objects_exchange> motorList;
+            control->motors->getListMotors(&motorList);
+            for(const auto& motor: motorList)
+            {
+                if(const auto* const simMotor = control->motors->getSimMotor(motor.index))
+                {
+                    checkpoint->motors[motor.name] = simMotor->getState();
+                }
+            }
+
+            getTimeMutex.lock();
+            checkpoint->simTime = dbSimTimePackage[0].d;
+            getTimeMutex.unlock();
+        }
+
+        bool Simulator::applyCheckpoint(const SimulationCheckpoint &checkpoint)
+        {
+            using DynamicObjectEnvireItem = envire::core::Item<DynamicObjectItem>;
+            auto* const graph = control->envireGraph_.get();
+
+            // resolve everything before changing anything, a checkpoint that
+            // does not fit the scene is rejected as a whole
+            size_t numBodies = 0;
+            const auto& rootVertex = graph->getVertex(SIM_CENTER_FRAME_NAME);
+            control->graphTreeView_->visitDfs(rootVertex, [graph, &numBodies](VertexDesc node, VertexDesc parent)
+            {
+                numBodies += graph->containsItems<DynamicObjectEnvireItem>(node);
+            });
+            if(numBodies != checkpoint.bodies.size())
+            {
+                LOG_ERROR("Simulator: the checkpoint holds %lu bodies, the scene %lu",
+                          checkpoint.bodies.size(), numBodies);
+                return false;
+            }
+            std::vector<DynamicObject*> dynamicObjects;
+            dynamicObjects.reserve(checkpoint.bodies.size());
+            for(const auto& body: checkpoint.bodies)
+            {
+                if(!graph->containsFrame(body.frame) ||
+                   !graph->containsItems<DynamicObjectEnvireItem>(body.frame))
+                {
+                    LOG_ERROR("Simulator: the checkpoint body \"%s\" is not in the scene",
+                              body.frame.c_str());
+                    return false;
+                }
+                dynamicObjects.push_back(graph->getItem<DynamicObjectEnvireItem>(body.frame)->getData().dynamicObject.get());
+            }
+            std::vector<core_objects_exchange> motorList;
+            control->motors->getListMotors(&motorList);
+            if(motorList.size() != checkpoint.motors.size())
+            {
+                LOG_ERROR("Simulator: the checkpoint holds %lu motors, the scene %lu",
+                          checkpoint.motors.size(), motorList.size());
+                return false;
+            }
+            std::vector<SimMotor*> simMotors;
+            simMotors.reserve(checkpoint.motors.size());
+            for(const auto& motor: checkpoint.motors)
+            {
+                auto* const simMotor = control->motors->getSimMotorByName(motor.first);
+                if(!simMotor)
+                {
+                    LOG_ERROR("Simulator: the checkpoint motor \"%s\" is not in the scene", motor.first.c_str());
+                    return false;
+                }
+                simMotors.push_back(simMotor);
+            }
+            auto* const jointManager = dynamic_cast<JointManager*>(control->joints.get());
+            std::vector<std::shared_ptr<SimJoint>> simJoints;
+            simJoints.reserve(checkpoint.joints.size());
+            for(const auto& joint: checkpoint.joints)
+            {
+                const auto simJoint = jointManager->getSimJoint(jointManager->getID(joint.name));
+                if(!simJoint)
+                {
+                    LOG_ERROR("Simulator: the checkpoint joint \"%s\" is not in the scene", joint.name.c_str());
+                    return false;
+                }
+                simJoints.push_back(simJoint);
+            }
+
+            for(size_t i = 0; i < dynamicObjects.size(); ++i)
+            {
+                const auto& body = checkpoint.bodies[i];
+                dynamicObjects[i]->setPosition(body.position);
+                dynamicObjects[i]->setRotation(body.rotation);
+                dynamicObjects[i]->setLinearVelocity(body.linearVelocity);
+                dynamicObjects[i]->setAngularVelocity(body.angularVelocity);
+            }
+            auto simMotor = simMotors.begin();
+            for(const auto& motor: checkpoint.motors)
+            {
+                (*simMotor++)->setState(motor.second);
+            }
+
+            // the joints follow the bodies, a deviation means the checkpoint
+            // was taken from a different scene with the same frame names
+            for(size_t i = 0; i < simJoints.size(); ++i)
+            {
+                const auto& joint = checkpoint.joints[i];
+                if(std::abs(simJoints[i]->getPosition() - joint.position) > 1e-3)
+                {
+                    LOG_WARN("Simulator: joint \"%s\" does not match the restored checkpoint", joint.name.c_str());
+                }
+            }
+
+            getTimeMutex.lock();
+            dbSimTimePackage[0].d = checkpoint.simTime;
+            getTimeMutex.unlock();
+            simStartTime = checkpoint.simTime;
+            simRealTime = 0;
+
+            // the poses changed without the physics stepping
+            posePropagator->invalidate();
+            return true;
+        }
+
         void Simulator::reloadObjects()
         {
             auto controlPtr = control.get();
@@ -2561,16 +3250,146 @@ namespace mars
 
         interfaces::sReal Simulator::getVectorCollision(Vector position, Vector ray)
         {
-            // todo: - order subworlds by bounding box ray collision
-            //       - don't continue with subworlds if collision distance
-            //         is already lower then bounding box collision
-            double min = -1, d;
-            for(auto &it: subWorlds)
+            // visit the subworlds in the order the ray enters their bounds and
+            // stop once the next box is farther away than the closest hit
+            const double length = ray.norm();
+            std::vector<std::pair<double, SubWorld*>> candidates;
+            candidates.reserve(subWorldList.size());
+            double tEnter;
+            for(auto *subWorld: subWorldList)
+            {
+                if(rayHitsBounds(position, ray, subWorld->getBounds(), &tEnter))
+                {
+                    candidates.emplace_back(tEnter*length, subWorld);
+                }
+            }
+            std::sort(candidates.begin(), candidates.end(),
+                      [](const std::pair<double, SubWorld*> &a, const std::pair<double, SubWorld*> &b)
+                      {
+                          return a.first < b.first;
+                      });
+
+            double min = length;
+            for(const auto &candidate: candidates)
+            {
+                if(candidate.first >= min)
+                {
+                    break;
+                }
+                const double d = candidate.second->control->collision->getVectorCollision(position, ray);
+                if(d < min)
+                {
+                    min = d;
+                }
+            }
+            return min;
+        }
+
+        void Simulator::getVectorCollisions(const VectorArray &origins, const VectorArray &directions,
+                                            interfaces::sReal *out, bool parallel)
+        {
+            assert(origins.size() == directions.size());
+            const size_t n = origins.size();
+            if(!(parallel || parallel_rays) || n < 2*rays_per_task ||
+               !collisionManager->allowsConcurrentRayQueries())
+            {
+                collideRays(origins, directions, out, 0, n);
+                return;
+            }
+
+            // every task writes a fixed range of out, so the result is
+            // independent of the scheduling
+            const size_t numTasks = (n + rays_per_task - 1) / rays_per_task;
+            rayPool->parallelFor(numTasks, [&](size_t task)
+                                 {
+                                     const size_t begin = task*rays_per_task;
+                                     collideRays(origins, directions, out, begin,
+                                                 std::min(n, begin + rays_per_task));
+                                 });
+        }
+
+        void Simulator::collideRays(const VectorArray &origins, const VectorArray &directions,
+                                    interfaces::sReal *out, size_t begin, size_t end)
+        {
+            if(begin >= end)
+            {
+                return;
+            }
+            for(size_t i = begin; i < end; ++i)
+            {
+                out[i] = directions.get(i).norm();
+            }
+
+            // rays of one batch usually share their origin, so visiting the
+            // closest worlds first lets the box test skip most of the others
+            const Vector reference = origins.get(begin);
+            std::vector<std::pair<WorldBounds, SubWorld*>> ordered;
+            ordered.reserve(subWorldList.size());
+            for(auto *subWorld: subWorldList)
+            {
+                ordered.emplace_back(subWorld->getBounds(), subWorld);
+            }
+            std::sort(ordered.begin(), ordered.end(),
+                      [&reference](const std::pair<WorldBounds, SubWorld*> &a,
+                                   const std::pair<WorldBounds, SubWorld*> &b)
+                      {
+                          return boundsDistance2(reference, a.first) < boundsDistance2(reference, b.first);
+                      });
+
+            double tEnter;
+            for(const auto &world: ordered)
+            {
+                const auto &bounds = world.first;
+                auto *collision = world.second->control->collision.get();
+                for(size_t i = begin; i < end; ++i)
+                {
+                    const Vector origin = origins.get(i);
+                    const Vector ray = directions.get(i);
+                    if(!rayHitsBounds(origin, ray, bounds, &tEnter) ||
+                       tEnter*ray.norm() >= out[i])
+                    {
+                        continue;
+                    }
+                    const double d = collision->getVectorCollision(origin, ray);
+                    if(d < out[i])
+                    {
+                        out[i] = d;
+                    }
+                }
+            }
+        }
+
+        std::vector<StepProfiler::PhaseStatistics> Simulator::getStepProfile() const
+        {
+            return stepProfiler->getStatistics();
+        }
+
+        void Simulator::resetStepProfile()
+        {
+            stepProfiler->reset();
+        }
+
+        bool Simulator::writeStepProfile(const std::string &filename) const
+        {
+            return stepProfiler->writeStatistics(filename);
+        }
+
+        uint64_t Simulator::recordPhase(size_t phase, uint64_t start)
+        {
+            const uint64_t end = StepProfiler::now();
+            stepProfiler->record(phase, end - start);
+            return end;
+        }
+
+        void Simulator::updateSubWorldBounds()
+        {
+            subWorldBounds->update(subWorldList, bounds_margin);
+
+            // the bounds after the step are used by the broadphase of the next step
+            for(const auto *subWorld: subWorldList)
             {
-                d = it.second->control->collision->getVectorCollision(position, ray);
-                if(min < 0 || min > d) min = d;
+                collisionManager->setBounds(subWorld->control->collision.get(), subWorld->getBounds());
             }
-            return d;
         }
 
     } // end of namespace core
@@ -8,8 +8,15 @@
 #pragma once
 
 #include "SubWorld.hpp"
+#include "SubWorldBounds.hpp"
+#include "ThreadPool.hpp"
+#include "RayCaster.hpp"
+#include "VectorArray.hpp"
 #include "CollisionManager.hpp"
 #include "AbsolutePoseExtender.hpp"
+#include "PosePropagator.hpp"
+#include "StepProfiler.hpp"
+#include "SimulationCheckpoint.hpp"
 
 #include <data_broker/DataPackage.h>
 #include <data_broker/ReceiverInterface.h>
@@ -71,6 +78,7 @@ namespace mars
          */
         class Simulator : public utils::Thread,
                           public interfaces::SimulatorInterface,
+                          public RayCaster,
                           public interfaces::GraphicsUpdateInterface,
                           public lib_manager::LibInterface,
                           public cfg_manager::CFGClient,
@@ -287,6 +295,96 @@ namespace mars
             // @getStepSizeS: Returns step size of the physics simulations in seconds.
             interfaces::sReal getStepSizeS() const;
             virtual interfaces::sReal getVectorCollision(utils::Vector position, utils::Vector ray);
+            /**
+             * Batched version of getVectorCollision(). Writes the collision
+             * distance of the ray origins[i] + directions[i] into out[i].
+             * The subworlds are visited once per batch instead of once per ray.
+             * \param out has to hold at least origins.size() values.
+             * \param parallel casts fixed chunks of the rays on a pool of
+             * their own. The "Simulator/parallel ray sensors" property
+             * enables this for all calls. It only takes effect if the
+             * collision plugins allow concurrent ray queries, see
+             * CollisionManager::setConcurrentRayQueries(). The result does
+             * not depend on the number of threads.
+             */
+            void getVectorCollisions(const VectorArray &origins, const VectorArray &directions,
+                                     interfaces::sReal *out, bool parallel = false) override;
+
+            /**
+             * Returns the latency statistics of the phases of step(), one
+             * entry per phase and plugin.
+             */
+            std::vector<StepProfiler::PhaseStatistics> getStepProfile() const;
+            void resetStepProfile();
+            /**
+             * Writes the step profile to the given file. The profile is also
+             * written on exit if "Simulator/profile file" is set.
+             */
+            bool writeStepProfile(const std::string &filename) const;
+
+            /**
+             * Status codes of runBatch(), used as exit code of a batch run.
+             */
+            enum BatchStatus
+            {
+                BATCH_OK = 0,
+                BATCH_SIM_FAULT = 1, ///< the physics stopped with "onPhysicsError" set to "shutdown"
+                BATCH_LOAD_FAILED = 2, ///< a scene given on the command line could not be loaded
+                BATCH_STATS_FAILED = 3 ///< the stats file could not be written
+            };
+
+            /**
+             * Runs the given number of steps in the calling thread as fast as
+             * possible, without realtime pacing and without waiting for the
+             * graphics. Writes the step rate and the step profile to the
+             * "Simulator/batch stats file" if it is set. The poses are
+             * propagated into the graph as often as the graphics would be
+             * synchronized and before the stats are written.
+             * runSimulation() calls this if "Simulator/batch steps" or
+             * --batch is set.
+             */
+            BatchStatus runBatch(unsigned long steps);
+
+            /**
+             * Returns true if runSimulation() executed a batch run. The host
+             * application then exits with getBatchStatus() instead of
+             * entering its event loop, so the Simulator is destroyed and
+             * its threads and plugins shut down normally.
+             */
+            bool isBatchRunFinished() const;
+            BatchStatus getBatchStatus() const;
+
+            /**
+             * Stores the poses and velocities of all bodies, the joint
+             * positions, the motor and controller states and the sim time.
+             * Returns the id to restore the checkpoint with.
+             */
+            unsigned long saveCheckpoint();
+            /**
+             * Sets the state of the checkpoint in place, the physics objects
+             * are kept. In contrast to resetSim() this is cheap enough to run
+             * between episodes. Returns false and leaves the simulation
+             * untouched if the checkpoint does not fit the current scene.
+             */
+            bool restoreCheckpoint(unsigned long id);
+            void removeCheckpoint(unsigned long id);
+            /**
+             * Moves the bodies back to their initial poses, stops them and
+             * resets the motors, the plugins and the sim time. The physics
+             * objects are kept, so this is much faster than reloading the
+             * world. resetSim() uses this if "Simulator/fast reset" is set.
+             * Objects that were added or removed since loading are not
+             * restored.
+             */
+            void resetInPlace();
+            /**
+             * Writes the current state to a binary file, e.g. after the
+             * scene settled. The file can be restored into the same scene with
+             * loadCheckpointFile() or on startup with --checkpoint or the
+             * "Simulator/checkpoint file" property.
+             */
+            bool saveCheckpointFile(const std::string &filename);
+            bool loadCheckpointFile(const std::string &filename);
 
         private:
 
@@ -313,6 +411,7 @@ namespace mars
             void setupPhysics();
             void setupCollisions();
             void loadConfigurations();
+            void writeProfilingFiles(); ///< writes the trace and profile files if they are set, only once
 
             int arg_no_gui, arg_run, arg_grid, arg_ortho;
             bool reloadSim, reloadGraphics;
@@ -322,15 +421,27 @@ namespace mars
             ode_physics::WorldPhysicsLoader* physicsLoader; // plugin reference
             ode_collision::CollisionSpaceLoader* collisionSpaceLoader; // plugin reference
             std::map<std::string, std::unique_ptr<SubWorld>> subWorlds;
+            std::vector<SubWorld*> subWorldList; ///< subWorlds in the order of their time entries
+            std::unique_ptr<ThreadPool> stepPool;
+            std::unique_ptr<ThreadPool> rayPool; ///< separate from stepPool, so the ray sensors do not wait for the step
             std::unique_ptr<CollisionManager> collisionManager;
             std::shared_ptr<interfaces::ControlCenter> control; ///< Pointer to instance of ControlCenter (created in Simulator::Simulator(lib_manager::LibManager *theManager))
             std::vector<LoadOptions> filesToLoad;
             bool sim_fault;
             bool exit_sim;
+            unsigned long batch_steps; ///< steps of a headless batch run, 0 for the interactive mode
+            std::string batch_stats_file;
+            bool batch_load_failed;
+            bool batch_finished;
+            BatchStatus batch_status;
+            bool profiling_files_written;
             Status simulationStatus;
             interfaces::sReal sync_time;
             bool my_real_time;
+            bool fast_reset;
             bool fast_step;
+            bool parallel_rays;
+            double bounds_margin; ///< added around the enclosing spheres of the geometries in the subworld bounds
 
             // graphics
             bool allow_draw;
@@ -364,10 +475,31 @@ namespace mars
             int std_port; ///< Controller port (default value: 1600)
             utils::Vector gravity;
             unsigned long dbPhysicsUpdateId;
-            unsigned long dbSimTimeId, dbSimDebugId;
+            unsigned long dbSimTimeId, dbSimDebugId, dbSubWorldTimeId;
             unsigned long realStartTime;
 
             std::unique_ptr<AbsolutePoseExtender> absolutePoseExtender;
+            std::unique_ptr<PosePropagator> posePropagator;
+            std::unique_ptr<SubWorldBounds> subWorldBounds;
+
+            // checkpoints
+            std::map<unsigned long, SimulationCheckpoint> checkpoints;
+            unsigned long nextCheckpointId;
+            std::string startCheckpointFile; ///< restored in runSimulation() after the scenes are loaded
+            bool startedFromCheckpoint;
+            utils::Mutex checkpointMutex;
+            void captureCheckpoint(SimulationCheckpoint *checkpoint);
+            bool applyCheckpoint(const SimulationCheckpoint &checkpoint);
+
+            // profiling of step()
+            struct ProfilePhases
+            {
+                size_t step, prePhysicsUpdate, clearPreviousStep, handleContacts;
+                size_t subWorldStep, subWorldBounds, updateMotors, dataBroker;
+            };
+            std::unique_ptr<StepProfiler> stepProfiler;
+            ProfilePhases profilePhases;
+            std::map<interfaces::PluginInterface*, size_t> pluginPhases; ///< only used in step()
 
             // plugins
             std::vector<interfaces::pluginStruct> allPlugins;
@@ -404,11 +536,21 @@ namespace mars
             cfg_manager::cfgPropertyStruct configPath;
             cfg_manager::cfgPropertyStruct cfgUseNow;
             cfg_manager::cfgPropertyStruct cfgAvgCountSteps;
+            cfg_manager::cfgPropertyStruct cfgParallelRays;
+            cfg_manager::cfgPropertyStruct cfgParallelContacts;
+            cfg_manager::cfgPropertyStruct cfgCollisionBroadphase;
+            cfg_manager::cfgPropertyStruct cfgBoundsMargin;
+            cfg_manager::cfgPropertyStruct cfgProfileFile;
+            cfg_manager::cfgPropertyStruct cfgTraceFile;
+            cfg_manager::cfgPropertyStruct cfgBatchSteps, cfgBatchStatsFile;
+            cfg_manager::cfgPropertyStruct cfgCheckpointFile;
+            cfg_manager::cfgPropertyStruct cfgFastReset;
 
             // data
             data_broker::DataPackage dbPhysicsUpdatePackage;
             data_broker::DataPackage dbSimTimePackage;
             data_broker::DataPackage dbSimDebugPackage;
+            data_broker::DataPackage dbSubWorldTimePackage;
 
         protected:
 
@@ -418,6 +560,13 @@ namespace mars
         private:
             void resetPoses();
             void reloadObjects();
+            void collideRays(const VectorArray &origins, const VectorArray &directions,
+                             interfaces::sReal *out, size_t begin, size_t end);
+            void updateSubWorldBounds();
+            /** Propagates the latest poses of the dynamic objects into the graph under the physics lock. */
+            void propagatePoses();
+            /** Records the time since start for the phase and returns the current time. */
+            uint64_t recordPhase(size_t phase, uint64_t start);
             bool pluginIsLoaded(const interfaces::pluginStruct& p) const;
         };
     } // end of namespace core
@@ -0,0 +1,148 @@
+/**
+ * \file StepProfiler.cpp
+ *
+ */
+
+#include "StepProfiler.hpp"
+
+#include <mars_utils/MutexLocker.h>
+
+#include <algorithm>
+#include <cstdio>
+
+namespace mars
+{
+    namespace core
+    {
+        StepProfiler::StepProfiler()
+        {
+        }
+
+        size_t StepProfiler::addPhase(const std::string &name)
+        {
+            utils::MutexLocker locker{&mutex};
+            const auto it = phaseIds.find(name);
+            if(it != phaseIds.end())
+            {
+                return it->second;
+            }
+            Phase phase;
+            phase.name = name;
+            phase.buckets.assign(numBuckets, 0);
+            phase.count = phase.sum = phase.max = 0;
+            phases.push_back(phase);
+            phaseIds[name] = phases.size() - 1;
+            return phases.size() - 1;
+        }
+
+        void StepProfiler::record(size_t phase, uint64_t duration)
+        {
+            utils::MutexLocker locker{&mutex};
+            auto &p = phases[phase];
+            ++p.buckets[bucketIndex(duration)];
+            ++p.count;
+            p.sum += duration;
+            p.max = std::max(p.max, duration);
+        }
+
+        std::vector<StepProfiler::PhaseStatistics> StepProfiler::getStatistics() const
+        {
+            utils::MutexLocker locker{&mutex};
+            std::vector<PhaseStatistics> statistics;
+            statistics.reserve(phases.size());
+            for(const auto &phase: phases)
+            {
+                PhaseStatistics s;
+                s.name = phase.name;
+                s.count = phase.count;
+                s.p50 = percentile(phase, 0.5);
+                s.p99 = percentile(phase, 0.99);
+                s.max = phase.max;
+                s.mean = phase.count ? static_cast<double>(phase.sum) / phase.count : 0.0;
+                statistics.push_back(s);
+            }
+            return statistics;
+        }
+
+        void StepProfiler::reset()
+        {
+            utils::MutexLocker locker{&mutex};
+            for(auto &phase: phases)
+            {
+                std::fill(phase.buckets.begin(), phase.buckets.end(), 0);
+                phase.count = phase.sum = phase.max = 0;
+            }
+        }
+
+        bool StepProfiler::writeStatistics(const std::string &filename) const
+        {
+            FILE *file = fopen(filename.c_str(), "w");
+            if(!file)
+            {
+                return false;
+            }
+            writeStatistics(file);
+            fclose(file);
+            return true;
+        }
+
+        void StepProfiler::writeStatistics(FILE *file) const
+        {
+            fprintf(file, "# phase count mean_us p50_us p99_us max_us\n");
+            for(const auto &s: getStatistics())
+            {
+                fprintf(file, "%s %lu %.3f %.3f %.3f %.3f\n", s.name.c_str(),
+                        static_cast<unsigned long>(s.count), s.mean*1e-3,
+                        s.p50*1e-3, s.p99*1e-3, s.max*1e-3);
+            }
+        }
+
+        size_t StepProfiler::bucketIndex(uint64_t value)
+        {
+            if(value < subBuckets)
+            {
+                return value;
+            }
+            size_t msb = 63;
+            while(!(value >> msb))
+            {
+                --msb;
+            }
+            const size_t group = msb - subBucketBits + 1;
+            const size_t sub = (value >> (msb - subBucketBits)) - subBuckets;
+            return group*subBuckets + sub;
+        }
+
+        uint64_t StepProfiler::bucketUpperBound(size_t index)
+        {
+            if(index < subBuckets)
+            {
+                return index;
+            }
+            const size_t shift = index/subBuckets - 1;
+            const uint64_t lower = static_cast<uint64_t>(subBuckets + index%subBuckets) << shift;
+            return lower + ((static_cast<uint64_t>(1) << shift) - 1);
+        }
+
+        uint64_t StepProfiler::percentile(const Phase &phase, double fraction)
+        {
+            if(phase.count == 0)
+            {
+                return 0;
+            }
+            // rank of the sample that is reported, 1 based
+            const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(fraction*phase.count + 0.5));
+            uint64_t seen = 0;
+            for(size_t i = 0; i < phase.buckets.size(); ++i)
+            {
+                seen += phase.buckets[i];
+                if(seen >= rank)
+                {
+                    return std::min(bucketUpperBound(i), phase.max);
+                }
+            }
+            return phase.max;
+        }
+
+    } // end of namespace core
+} // end of namespace mars
@@ -0,0 +1,95 @@
+/**
+ * \file StepProfiler.hpp
+ * \brief Latency histograms of the phases of a simulation step.
+ *
+ */
+
+#pragma once
+
+#include <mars_utils/Mutex.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace mars
+{
+    namespace core
+    {
+        /**
+         * \brief Collects the durations of named phases in histograms.
+         *
+         * Durations are measured with a monotonic nanosecond clock and
+         * sorted into log-linear buckets: every power of two is split into
+         * 16 linear sub-buckets, so the reported percentiles are at most
+         * 1/16 above the real value while a phase needs a fixed amount of
+         * memory independent of the number of samples.
+         */
+        class StepProfiler
+        {
+        public:
+            struct PhaseStatistics
+            {
+                std::string name;
+                uint64_t count;
+                // durations in nanoseconds
+                uint64_t p50, p99, max;
+                double mean;
+            };
+
+            StepProfiler();
+
+            /** Monotonic time in nanoseconds. */
+            static uint64_t now()
+            {
+                return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now().time_since_epoch()).count();
+            }
+
+            /**
+             * Returns the id of the phase with the given name and creates
+             * the phase if it does not exist yet.
+             */
+            size_t addPhase(const std::string &name);
+
+            void record(size_t phase, uint64_t duration);
+
+            /** Statistics of all phases in the order they were added. */
+            std::vector<PhaseStatistics> getStatistics() const;
+
+            /** Clears the samples of all phases. The phase ids stay valid. */
+            void reset();
+
+            /**
+             * Writes the statistics as a table to the given file.
+             * Returns false if the file cannot be written.
+             */
+            bool writeStatistics(const std::string &filename) const;
+            /** Writes the statistics table to an open file. */
+            void writeStatistics(FILE *file) const;
+
+        private:
+            static const size_t subBucketBits = 4;
+            static const size_t subBuckets = 1 << subBucketBits;
+            static const size_t numBuckets = (64 - subBucketBits + 1) * subBuckets;
+
+            struct Phase
+            {
+                std::string name;
+                std::vector<uint64_t> buckets;
+                uint64_t count, sum, max;
+            };
+
+            static size_t bucketIndex(uint64_t value);
+            static uint64_t bucketUpperBound(size_t index);
+            static uint64_t percentile(const Phase &phase, double fraction);
+
+            mutable utils::Mutex mutex;
+            std::vector<Phase> phases;
+            std::map<std::string, size_t> phaseIds;
+        };
+    } // end of namespace core
+} // end of namespace mars
@@ -5,36 +5,50 @@
  */
 
 #include "SubWorld.hpp"
-#include <mars_utils/misc.h>
-#include <getopt.h>
+#include "Tracer.hpp"
+
+#include <mars_utils/MutexLocker.h>
+
+#include <chrono>
 
 namespace mars
 {
     namespace core
     {
-        void SubWorld::run()
+        SubWorld::SubWorld() : stepTimeSum{0.0}, stepCount{0}
+        {
+            // never cull the world before its bounds are calculated in the first step
+            bounds.bounded = false;
+        }
+
+        void SubWorld::step()
+        {
+            TraceScope trace{"SubWorld::step"};
+            const auto start = std::chrono::steady_clock::now();
+            control->physics->stepTheWorld();
+            const std::chrono::duration<double, std::milli> duration = std::chrono::steady_clock::now() - start;
+            stepTimeSum += duration.count();
+            ++stepCount;
+        }
+
+        double SubWorld::takeAvgStepTime()
+        {
+            const double avg = stepCount > 0 ? stepTimeSum / stepCount : 0.0;
+            stepTimeSum = 0.0;
+            stepCount = 0;
+            return avg;
+        }
+
+        WorldBounds SubWorld::getBounds() const
+        {
+            utils::MutexLocker locker{&boundsMutex};
+            return bounds;
+        }
+
+        void SubWorld::setBounds(const WorldBounds &bounds)
         {
-            calcStep = false;
-            stopThread = false;
-            struct timeval tv;
-            tv.tv_sec = 0;
-            tv.tv_usec = 1000L;
-
-            while(!stopThread)
-            {
-                if(calcStep)
-                {
-                    control->physics->stepTheWorld();
-                    calcStep = false;
-                }
-                else
-                {
-                    //fprintf(stderr, "sleep.");
-                    utils::msleep(1);
-
-                    //select(0, 0, 0, 0, &tv);
-                }
-            }
+            utils::MutexLocker locker{&boundsMutex};
+            this->bounds = bounds;
         }
 
     } // end of namespace core
@@ -7,22 +7,55 @@
 
 #pragma once
 
-#include <mars_utils/Thread.h>
 #include <mars_interfaces/sim/ControlCenter.h>
 #include <mars_interfaces/sim/PhysicsInterface.h>
+#include <mars_utils/Mutex.h>
+#include <envire_core/graph/GraphTypes.hpp>
+
+#include "WorldBounds.hpp"
 
 namespace mars
 {
     namespace core
     {
-        class SubWorld : public utils::Thread
+        /**
+         * A physics world with its own collision space. The step is executed
+         * as a task of the simulator's thread pool.
+         */
+        class SubWorld
         {
         public:
+            SubWorld();
+
+            /**
+             * Calculates one physics step and accounts the time it took.
+             */
+            void step();
+
+            /**
+             * Returns the average step time in ms since the last call and
+             * restarts the averaging.
+             */
+            double takeAvgStepTime();
+
+            /**
+             * Returns the bounds after the last step. Ray queries of sensors
+             * read them from other threads.
+             */
+            WorldBounds getBounds() const;
+            void setBounds(const WorldBounds &bounds);
+
             std::shared_ptr<interfaces::SubControlCenter> control;
-            bool calcStep, stopThread;
+            envire::core::GraphTraits::vertex_descriptor vertex; ///< frame of the World item
+
+        private:
+            WorldBounds bounds; ///< updated by the simulator after each step
+            mutable utils::Mutex boundsMutex;
 
-        protected:
-            void run() override;
+            // only accessed by the task stepping this world and by the
+            // simulator thread after the pool finished the step
+            double stepTimeSum;
+            int stepCount;
         };
     } // end of namespace core
 } // end of namespace mars
@@ -0,0 +1,255 @@
+/**
+ * \file SubWorldBounds.cpp
+ *
+ */
+
+#include "SubWorldBounds.hpp"
+#include "SubWorld.hpp"
+
+#include <envire_types/geometry/Box.hpp>
+#include <envire_types/geometry/Capsule.hpp>
+#include <envire_types/geometry/Cylinder.hpp>
+#include <envire_types/geometry/Mesh.hpp>
+#include <envire_types/geometry/Plane.hpp>
+#include <envire_types/geometry/Sphere.hpp>
+#include <envire_types/geometry/Heightfield.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <type_traits>
+
+namespace mars
+{
+    namespace core
+    {
+        using namespace interfaces;
+        using namespace envire::types::geometry;
+        using DynamicObjectEnvireItem = envire::core::Item<DynamicObjectItem>;
+        using AbsolutePoseEnvireItem = envire::core::Item<AbsolutePose>;
+
+        namespace
+        {
+            // returns the radius of the sphere around the frame that encloses
+            // the geometry item of type T in node, or a negative value if the
+            // node contains none
+            template <typename T>
+            double enclosingRadius(envire::core::EnvireGraph &graph,
+                                   envire::core::GraphTraits::vertex_descriptor node)
+            {
+                if(!graph.containsItems<envire::core::Item<T>>(node))
+                {
+                    return -1.0;
+                }
+                auto config = graph.getItem<envire::core::Item<T>>(node)->getData().getFullConfigMap();
+                const double radius = config.hasKey("radius") ? static_cast<double>(config["radius"]) : 0.0;
+                const double length = config.hasKey("length") ? static_cast<double>(config["length"]) : 0.0;
+                if(std::is_same<T, Box>::value)
+                {
+                    auto &size = config["size"];
+                    const utils::Vector extent{static_cast<double>(size["x"]),
+                                               static_cast<double>(size["y"]),
+                                               static_cast<double>(size["z"])};
+                    return 0.5*extent.norm();
+                }
+                if(std::is_same<T, Capsule>::value)
+                {
+                    return radius + 0.5*length;
+                }
+                if(std::is_same<T, Cylinder>::value)
+                {
+                    return std::sqrt(radius*radius + 0.25*length*length);
+                }
+                return radius;
+            }
+        }
+
+        SubWorldBounds::SubWorldBounds(std::shared_ptr<envire::core::EnvireGraph> envireGraph,
+                                       std::shared_ptr<envire::core::TreeView> graphTreeView) :
+            envireGraph{envireGraph}, graphTreeView{graphTreeView}, structureChanged{true}
+        {
+            GraphEventDispatcher::subscribe(envireGraph.get());
+        }
+
+        SubWorldBounds::~SubWorldBounds()
+        {
+            GraphEventDispatcher::unsubscribe();
+        }
+
+        void SubWorldBounds::frameAdded(const envire::core::FrameAddedEvent& e)
+        {
+            structureChanged = true;
+        }
+
+        void SubWorldBounds::frameRemoved(const envire::core::FrameRemovedEvent& e)
+        {
+            structureChanged = true;
+        }
+
+        void SubWorldBounds::edgeAdded(const envire::core::EdgeAddedEvent& e)
+        {
+            structureChanged = true;
+        }
+
+        void SubWorldBounds::edgeRemoved(const envire::core::EdgeRemovedEvent& e)
+        {
+            structureChanged = true;
+        }
+
+        void SubWorldBounds::itemAdded(const envire::core::ItemAddedEvent& e)
+        {
+            if(isRelevantItem(e.item))
+            {
+                structureChanged = true;
+            }
+        }
+
+        void SubWorldBounds::itemRemoved(const envire::core::ItemRemovedEvent& e)
+        {
+            if(isRelevantItem(e.item))
+            {
+                structureChanged = true;
+            }
+        }
+
+        bool SubWorldBounds::isRelevantItem(const envire::core::ItemBase::Ptr &item) const
+        {
+            // the cache holds pointers to these items or depends on the geometries
+            return boost::dynamic_pointer_cast<DynamicObjectEnvireItem>(item) ||
+                boost::dynamic_pointer_cast<AbsolutePoseEnvireItem>(item) ||
+                boost::dynamic_pointer_cast<envire::core::Item<Box>>(item) ||
+                boost::dynamic_pointer_cast<envire::core::Item<Capsule>>(item) ||
+                boost::dynamic_pointer_cast<envire::core::Item<Cylinder>>(item) ||
+                boost::dynamic_pointer_cast<envire::core::Item<Sphere>>(item) ||
+                boost::dynamic_pointer_cast<envire::core::Item<Mesh>>(item) ||
+                boost::dynamic_pointer_cast<envire::core::Item<Plane>>(item) ||
+                boost::dynamic_pointer_cast<envire::core::Item<Heightfield>>(item);
+        }
+
+        void SubWorldBounds::update(const std::vector<SubWorld*> &subWorlds, double margin)
+        {
+            bool sameWorlds = worlds.size() == subWorlds.size();
+            for(size_t i = 0; sameWorlds && i < worlds.size(); ++i)
+            {
+                sameWorlds = worlds[i].subWorld == subWorlds[i];
+            }
+            if(structureChanged || !sameWorlds)
+            {
+                collect(subWorlds);
+            }
+
+            for(size_t i = 0; i < worlds.size(); ++i)
+            {
+                const auto &world = worlds[i];
+                WorldBounds bounds;
+                bounds.bounded = world.bounded && margin >= 0.0;
+                if(bounds.bounded)
+                {
+                    for(const auto &geometry: world.geometries)
+                    {
+                        utils::Vector position = geometry.absolutePose->getPosition();
+                        if(geometry.anchorObject)
+                        {
+                            utils::Vector anchorPosition;
+                            utils::Quaternion anchorRotation;
+                            geometry.anchorObject->getPosition(&anchorPosition);
+                            geometry.anchorObject->getRotation(&anchorRotation);
+                            const utils::Vector offset = geometry.anchorPose->getRotation().inverse() *
+                                (position - geometry.anchorPose->getPosition());
+                            position = anchorPosition + anchorRotation * offset;
+                        }
+                        // never cull a world with an exploded body
+                        if(!position.allFinite())
+                        {
+                            bounds.bounded = false;
+                            break;
+                        }
+
+                        const utils::Vector extent = utils::Vector::Constant(geometry.radius + margin);
+                        if(bounds.empty)
+                        {
+                            bounds.min = position - extent;
+                            bounds.max = position + extent;
+                            bounds.empty = false;
+                        }
+                        else
+                        {
+                            bounds.min = bounds.min.cwiseMin(position - extent);
+                            bounds.max = bounds.max.cwiseMax(position + extent);
+                        }
+                    }
+                }
+                subWorlds[i]->setBounds(bounds);
+            }
+        }
+
+        void SubWorldBounds::collect(const std::vector<SubWorld*> &subWorlds)
+        {
+            structureChanged = false;
+            worlds.clear();
+            worlds.reserve(subWorlds.size());
+            for(const auto *subWorld: subWorlds)
+            {
+                worlds.push_back(WorldGeometries{subWorld, true, {}});
+                collectWorld(worlds.back(), subWorld->vertex);
+            }
+        }
+
+        void SubWorldBounds::collectWorld(WorldGeometries &world, VertexDesc vertex)
+        {
+            struct Anchor
+            {
+                DynamicObject *object = nullptr;
+                const AbsolutePose *pose = nullptr;
+            };
+            std::map<VertexDesc, Anchor> anchors;
+            auto &graph = *envireGraph;
+            auto visitor = [&](VertexDesc node, VertexDesc parent)
+            {
+                Anchor anchor;
+                const auto parentAnchor = anchors.find(parent);
+                if(parentAnchor != anchors.end())
+                {
+                    anchor = parentAnchor->second;
+                }
+
+                // CAUTION: like the rest of the core we assume that there is at most
+                // one DynamicObjectItem and one AbsolutePose in the frame
+                const AbsolutePose *absolutePose = nullptr;
+                if(graph.containsItems<AbsolutePoseEnvireItem>(node))
+                {
+                    absolutePose = &(graph.getItem<AbsolutePoseEnvireItem>(node)->getData());
+                    if(graph.containsItems<DynamicObjectEnvireItem>(node))
+                    {
+                        anchor.object = graph.getItem<DynamicObjectEnvireItem>(node)->getData().dynamicObject.get();
+                        anchor.pose = absolutePose;
+                    }
+                }
+                anchors[node] = anchor;
+
+                // the extent of meshes, planes and heightfields is not known
+                if(graph.containsItems<envire::core::Item<Plane>>(node) ||
+                   graph.containsItems<envire::core::Item<Heightfield>>(node) ||
+                   graph.containsItems<envire::core::Item<Mesh>>(node))
+                {
+                    world.bounded = false;
+                    return;
+                }
+                if(!absolutePose)
+                {
+                    return;
+                }
+                double radius = enclosingRadius<Box>(graph, node);
+                radius = std::max(radius, enclosingRadius<Capsule>(graph, node));
+                radius = std::max(radius, enclosingRadius<Cylinder>(graph, node));
+                radius = std::max(radius, enclosingRadius<Sphere>(graph, node));
+                if(radius >= 0.0)
+                {
+                    world.geometries.push_back(Geometry{absolutePose, anchor.object, anchor.pose, radius});
+                }
+            };
+            graphTreeView->visitDfs(vertex, visitor);
+        }
+
+    } // end of namespace core
+} // end of namespace mars
@@ -0,0 +1,95 @@
+/**
+ * \file SubWorldBounds.hpp
+ * \brief Estimates the bounds of the subworlds from their collision geometries.
+ *
+ */
+
+#pragma once
+
+#include "WorldBounds.hpp"
+
+#include <envire_core/events/GraphEventDispatcher.hpp>
+#include <envire_core/graph/EnvireGraph.hpp>
+#include <envire_core/graph/TreeView.hpp>
+#include <mars_interfaces/sim/AbsolutePose.hpp>
+#include <mars_interfaces/sim/DynamicObject.hpp>
+
+#include <atomic>
+#include <vector>
+
+namespace mars
+{
+    namespace core
+    {
+        class SubWorld;
+
+        /**
+         * \brief Updates the bounds of the subworlds after each step.
+         *
+         * Every Box, Capsule, Cylinder and Sphere below a subworld is
+         * covered by the sphere around its frame that encloses the geometry,
+         * enlarged by a margin for the motion until the next update. The
+         * geometry frames and their item pointers are collected once and
+         * only collected again when frames, edges or the relevant items
+         * change. Meshes, planes and heightfields make a world unbounded.
+         *
+         * Frame positions are taken relative to the closest frame with a
+         * dynamic object above them, since the absolute poses of static
+         * child frames are only updated when the graphics is drawn.
+         *
+         * update() caches item pointers and has to be called with the
+         * physics blocked.
+         */
+        class SubWorldBounds : public envire::core::GraphEventDispatcher
+        {
+        public:
+            SubWorldBounds(std::shared_ptr<envire::core::EnvireGraph> envireGraph,
+                           std::shared_ptr<envire::core::TreeView> graphTreeView);
+            ~SubWorldBounds();
+
+            /**
+             * Calculates the bounds of the subworlds and publishes them with
+             * SubWorld::setBounds(). A negative margin makes all worlds
+             * unbounded.
+             */
+            void update(const std::vector<SubWorld*> &subWorlds, double margin);
+
+            virtual void frameAdded(const envire::core::FrameAddedEvent& e) override;
+            virtual void frameRemoved(const envire::core::FrameRemovedEvent& e) override;
+            virtual void edgeAdded(const envire::core::EdgeAddedEvent& e) override;
+            virtual void edgeRemoved(const envire::core::EdgeRemovedEvent& e) override;
+            virtual void itemAdded(const envire::core::ItemAddedEvent& e) override;
+            virtual void itemRemoved(const envire::core::ItemRemovedEvent& e) override;
+
+        private:
+            using VertexDesc = envire::core::GraphTraits::vertex_descriptor;
+
+            struct Geometry
+            {
+                const interfaces::AbsolutePose *absolutePose;
+                // the closest dynamic object above the frame or the frame
+                // itself, nullptr for geometries of static frames
+                interfaces::DynamicObject *anchorObject;
+                const interfaces::AbsolutePose *anchorPose;
+                double radius; ///< of the sphere enclosing the geometry
+            };
+
+            struct WorldGeometries
+            {
+                const SubWorld *subWorld;
+                bool bounded;
+                std::vector<Geometry> geometries;
+            };
+
+            void collect(const std::vector<SubWorld*> &subWorlds);
+            void collectWorld(WorldGeometries &world, VertexDesc vertex);
+            bool isRelevantItem(const envire::core::ItemBase::Ptr &item) const;
+
+            std::vector<WorldGeometries> worlds;
+            std::shared_ptr<envire::core::EnvireGraph> envireGraph;
+            std::shared_ptr<envire::core::TreeView> graphTreeView;
+            // the graph events can be emitted by any thread
+            std::atomic<bool> structureChanged;
+        };
+    } // end of namespace core
+} // end of namespace mars
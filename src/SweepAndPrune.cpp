@@ -0,0 +1,137 @@
+/**
+ * \file SweepAndPrune.cpp
+ *
+ */
+
+#include "SweepAndPrune.hpp"
+
+#include <algorithm>
+
+namespace mars
+{
+    namespace core
+    {
+        SweepAndPrune::SweepAndPrune() : endpointsOutdated{true}
+        {
+        }
+
+        void SweepAndPrune::resize(size_t numItems)
+        {
+            WorldBounds unbounded;
+            unbounded.bounded = false;
+            itemBounds.assign(numItems, unbounded);
+            endpointsOutdated = true;
+        }
+
+        size_t SweepAndPrune::size() const
+        {
+            return itemBounds.size();
+        }
+
+        void SweepAndPrune::setBounds(size_t item, const WorldBounds &bounds)
+        {
+            WorldBounds valid = bounds;
+            if(valid.bounded && !valid.empty &&
+               !(valid.min.allFinite() && valid.max.allFinite() &&
+                 (valid.min.array() <= valid.max.array()).all()))
+            {
+                valid.bounded = false;
+            }
+
+            auto& current = itemBounds[item];
+            // the endpoints only hold the bounded non empty items
+            if(current.bounded != valid.bounded || current.empty != valid.empty)
+            {
+                endpointsOutdated = true;
+            }
+            current = valid;
+        }
+
+        void SweepAndPrune::findOverlappingPairs(std::vector<std::pair<size_t, size_t>> *pairs)
+        {
+            pairs->clear();
+            if(endpointsOutdated)
+            {
+                endpoints.clear();
+                for(size_t i=0; i<itemBounds.size(); ++i)
+                {
+                    if(itemBounds[i].bounded && !itemBounds[i].empty)
+                    {
+                        endpoints.push_back(Endpoint{0.0, i, true});
+                        endpoints.push_back(Endpoint{0.0, i, false});
+                    }
+                }
+                endpointsOutdated = false;
+            }
+            for(auto& endpoint: endpoints)
+            {
+                const auto& bounds = itemBounds[endpoint.item];
+                endpoint.value = endpoint.isMin ? bounds.min.x() : bounds.max.x();
+            }
+            // the order of the last call is almost sorted, so insertion
+            // sort is close to linear; touching intervals overlap
+            auto less = [](const Endpoint &a, const Endpoint &b)
+            {
+                return a.value < b.value || (a.value == b.value && a.isMin && !b.isMin);
+            };
+            for(size_t i=1; i<endpoints.size(); ++i)
+            {
+                const Endpoint endpoint = endpoints[i];
+                size_t j = i;
+                for(; j>0 && less(endpoint, endpoints[j-1]); --j)
+                {
+                    endpoints[j] = endpoints[j-1];
+                }
+                endpoints[j] = endpoint;
+            }
+
+            activeItems.clear();
+            for(const auto& endpoint: endpoints)
+            {
+                if(!endpoint.isMin)
+                {
+                    // the bounds are valid, so the min endpoint always came first
+                    const auto active = std::find(activeItems.begin(), activeItems.end(), endpoint.item);
+                    if(active != activeItems.end())
+                    {
+                        *active = activeItems.back();
+                        activeItems.pop_back();
+                    }
+                    continue;
+                }
+                const auto& bounds = itemBounds[endpoint.item];
+                for(const size_t other: activeItems)
+                {
+                    const auto& otherBounds = itemBounds[other];
+                    if(bounds.min.y() <= otherBounds.max.y() && otherBounds.min.y() <= bounds.max.y() &&
+                       bounds.min.z() <= otherBounds.max.z() && otherBounds.min.z() <= bounds.max.z())
+                    {
+                        pairs->emplace_back(std::min(endpoint.item, other), std::max(endpoint.item, other));
+                    }
+                }
+                activeItems.push_back(endpoint.item);
+            }
+
+            // unbounded items overlap every item that is not culled
+            for(size_t l=0; l<itemBounds.size(); ++l)
+            {
+                if(itemBounds[l].bounded)
+                {
+                    continue;
+                }
+                for(size_t k=0; k<itemBounds.size(); ++k)
+                {
+                    if(k == l || (itemBounds[k].bounded && itemBounds[k].empty) ||
+                       (!itemBounds[k].bounded && k < l))
+                    {
+                        continue;
+                    }
+                    pairs->emplace_back(std::min(l, k), std::max(l, k));
+                }
+            }
+
+            std::sort(pairs->begin(), pairs->end());
+        }
+
+    } // end of namespace core
+} // end of namespace mars
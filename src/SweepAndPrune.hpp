@@ -0,0 +1,62 @@
+/**
+ * \file SweepAndPrune.hpp
+ * \brief Finds the pairs of items with overlapping bounds.
+ *
+ */
+
+#pragma once
+
+#include "WorldBounds.hpp"
+
+#include <utility>
+#include <vector>
+
+namespace mars
+{
+    namespace core
+    {
+        /**
+         * \brief Sweep and prune along x over a fixed number of items.
+         *
+         * The endpoints of the x intervals are kept sorted between the
+         * calls, so the insertion sort is close to linear while the items
+         * move coherently. Unbounded items overlap every item that is not
+         * culled, empty items never overlap. Bounds that are not finite or
+         * inverted (e.g. of an exploded body) are treated as unbounded.
+         */
+        class SweepAndPrune
+        {
+        public:
+            SweepAndPrune();
+
+            /**
+             * Sets the number of items, all items are unbounded afterwards.
+             */
+            void resize(size_t numItems);
+
+            size_t size() const;
+
+            void setBounds(size_t item, const WorldBounds &bounds);
+
+            /**
+             * Sets pairs to the pairs (l, k), l < k, of overlapping items in
+             * lexicographical order. Touching intervals overlap.
+             */
+            void findOverlappingPairs(std::vector<std::pair<size_t, size_t>> *pairs);
+
+        private:
+            // an end of the x interval of an item's bounds
+            struct Endpoint
+            {
+                double value;
+                size_t item;
+                bool isMin;
+            };
+
+            std::vector<WorldBounds> itemBounds; ///< per item
+            std::vector<Endpoint> endpoints; ///< of the bounded non empty items, sorted
+            bool endpointsOutdated;
+            std::vector<size_t> activeItems;
+        };
+    } // end of namespace core
+} // end of namespace mars
@@ -0,0 +1,175 @@
+/**
+ * \file ThreadPool.cpp
+ *
+ */
+
+#include "ThreadPool.hpp"
+#include "Tracer.hpp"
+
+namespace mars
+{
+    namespace core
+    {
+        namespace
+        {
+            // set while a thread executes tasks of a pool to detect nested calls
+            thread_local bool inPoolTask = false;
+        }
+
+        ThreadPool::ThreadPool(size_t numThreads) :
+            currentTask{nullptr}, pendingTasks{0}, generation{0}, stopPool{false}
+        {
+            if(numThreads == 0)
+            {
+                numThreads = std::thread::hardware_concurrency();
+            }
+            if(numThreads == 0)
+            {
+                numThreads = 1;
+            }
+
+            // the last queue belongs to the thread calling parallelFor
+            for(size_t i = 0; i < numThreads; ++i)
+            {
+                queues.emplace_back(new TaskQueue);
+            }
+            for(size_t i = 0; i + 1 < numThreads; ++i)
+            {
+                workers.emplace_back(&ThreadPool::workerLoop, this, i);
+            }
+        }
+
+        ThreadPool::~ThreadPool()
+        {
+            {
+                std::lock_guard<std::mutex> lock{jobMutex};
+                stopPool = true;
+            }
+            jobAvailable.notify_all();
+            for(auto &worker: workers)
+            {
+                worker.join();
+            }
+        }
+
+        size_t ThreadPool::getNumThreads() const
+        {
+            return queues.size();
+        }
+
+        void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)>& task)
+        {
+            if(count == 0)
+            {
+                return;
+            }
+            if(count == 1 || workers.empty() || inPoolTask)
+            {
+                for(size_t i = 0; i < count; ++i)
+                {
+                    task(i);
+                }
+                return;
+            }
+
+            std::lock_guard<std::mutex> dispatchLock{dispatchMutex};
+            unsigned long jobGeneration;
+            {
+                std::lock_guard<std::mutex> lock{jobMutex};
+                currentTask = &task;
+                pendingTasks.store(count, std::memory_order_relaxed);
+                jobGeneration = ++generation;
+            }
+            for(size_t i = 0; i < count; ++i)
+            {
+                auto &queue = *queues[i % queues.size()];
+                std::lock_guard<std::mutex> lock{queue.mutex};
+                queue.tasks.push_back(QueuedTask{jobGeneration, i});
+            }
+            jobAvailable.notify_all();
+
+            processTasks(queues.size() - 1, jobGeneration, task);
+
+            std::unique_lock<std::mutex> lock{jobMutex};
+            jobDone.wait(lock, [this]() { return pendingTasks.load(std::memory_order_acquire) == 0; });
+            currentTask = nullptr;
+        }
+
+        void ThreadPool::workerLoop(size_t queueIndex)
+        {
+            Tracer::setThreadName("ThreadPool worker " + std::to_string(queueIndex));
+            unsigned long seenGeneration = 0;
+            while(true)
+            {
+                const std::function<void(size_t)> *task;
+                {
+                    std::unique_lock<std::mutex> lock{jobMutex};
+                    jobAvailable.wait(lock, [this, seenGeneration]() { return stopPool || generation != seenGeneration; });
+                    if(stopPool)
+                    {
+                        return;
+                    }
+                    seenGeneration = generation;
+                    task = currentTask;
+                }
+                // a late worker may wake up after the job is done, the task
+                // is reset then and no index of its generation is left
+                if(!task)
+                {
+                    continue;
+                }
+                processTasks(queueIndex, seenGeneration, *task);
+            }
+        }
+
+        void ThreadPool::processTasks(size_t queueIndex, unsigned long jobGeneration,
+                                      const std::function<void(size_t)> &task)
+        {
+            size_t index;
+            inPoolTask = true;
+            while(popTask(queueIndex, jobGeneration, &index) ||
+                  stealTask(queueIndex, jobGeneration, &index))
+            {
+                task(index);
+                // the release pairs with the acquire in parallelFor so all
+                // writes of the task are visible once the job is done
+                if(pendingTasks.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                {
+                    std::lock_guard<std::mutex> lock{jobMutex};
+                    jobDone.notify_all();
+                }
+            }
+            inPoolTask = false;
+        }
+
+        bool ThreadPool::popTask(size_t queueIndex, unsigned long jobGeneration, size_t *task)
+        {
+            auto &queue = *queues[queueIndex];
+            std::lock_guard<std::mutex> lock{queue.mutex};
+            if(queue.tasks.empty() || queue.tasks.front().generation != jobGeneration)
+            {
+                return false;
+            }
+            *task = queue.tasks.front().index;
+            queue.tasks.pop_front();
+            return true;
+        }
+
+        bool ThreadPool::stealTask(size_t queueIndex, unsigned long jobGeneration, size_t *task)
+        {
+            for(size_t i = 1; i < queues.size(); ++i)
+            {
+                auto &queue = *queues[(queueIndex + i) % queues.size()];
+                std::lock_guard<std::mutex> lock{queue.mutex};
+                if(!queue.tasks.empty() && queue.tasks.back().generation == jobGeneration)
+                {
+                    *task = queue.tasks.back().index;
+                    queue.tasks.pop_back();
+                    return true;
+                }
+            }
+            return false;
+        }
+
+    } // end of namespace core
+} // end of namespace mars
@@ -0,0 +1,97 @@
+/**
+ * \file ThreadPool.hpp
+ * \brief Bounded work-stealing thread pool used for the parallel parts of
+ * the simulation step.
+ *
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace mars
+{
+    namespace core
+    {
+        /**
+         * \brief A fixed set of worker threads executing indexed tasks.
+         *
+         * Each call to parallelFor() distributes the task indices round-robin
+         * over one queue per worker plus one queue for the calling thread.
+         * Every participant works on its own queue first and steals from the
+         * back of the other queues once it runs empty, so long running tasks
+         * do not leave the remaining threads idle.
+         *
+         * parallelFor() calls from different threads are serialized. A nested
+         * call from inside a task is executed serially on the calling thread.
+         */
+        class ThreadPool
+        {
+        public:
+            /**
+             * \param numThreads Total number of threads working on a job,
+             * including the caller of parallelFor(). 0 selects the hardware
+             * concurrency.
+             */
+            explicit ThreadPool(size_t numThreads = 0);
+            ~ThreadPool();
+
+            ThreadPool(const ThreadPool&) = delete;
+            ThreadPool& operator=(const ThreadPool&) = delete;
+
+            /**
+             * Returns the number of threads working on a job, including the caller.
+             */
+            size_t getNumThreads() const;
+
+            /**
+             * Executes task(i) for every i in [0, count) and returns after
+             * all tasks have finished.
+             */
+            void parallelFor(size_t count, const std::function<void(size_t)>& task);
+
+        private:
+            /**
+             * A task index tagged with the job it belongs to, so a thread
+             * leaving a finished job never takes an index of the next one.
+             */
+            struct QueuedTask
+            {
+                unsigned long generation;
+                size_t index;
+            };
+
+            struct TaskQueue
+            {
+                std::mutex mutex;
+                std::deque<QueuedTask> tasks;
+            };
+
+            void workerLoop(size_t queueIndex);
+            void processTasks(size_t queueIndex, unsigned long jobGeneration,
+                              const std::function<void(size_t)> &task);
+            bool popTask(size_t queueIndex, unsigned long jobGeneration, size_t *task);
+            bool stealTask(size_t queueIndex, unsigned long jobGeneration, size_t *task);
+
+            std::vector<std::thread> workers;
+            std::vector<std::unique_ptr<TaskQueue>> queues;
+
+            std::mutex dispatchMutex; ///< serializes parallelFor calls
+            std::mutex jobMutex;
+            std::condition_variable jobAvailable, jobDone;
+            // the job state is published under jobMutex before any index of
+            // the job is queued
+            const std::function<void(size_t)> *currentTask;
+            std::atomic<size_t> pendingTasks;
+            unsigned long generation;
+            bool stopPool;
+        };
+    } // end of namespace core
+} // end of namespace mars
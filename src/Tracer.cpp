@@ -0,0 +1,173 @@
+/**
+ * \file Tracer.cpp
+ *
+ */
+
+#include "Tracer.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace mars
+{
+    namespace core
+    {
+        namespace
+        {
+            struct TraceEvent
+            {
+                const char *name;
+                uint64_t time; // ns
+                char phase;
+            };
+
+            const size_t chunkSize = 4096;
+            const size_t maxChunks = 1024; // 4M events per thread
+
+            // Written only by its thread. The number of events is published
+            // with release semantics after the event is stored, so a reader
+            // sees complete events only.
+            struct ThreadBuffer
+            {
+                ThreadBuffer(unsigned long id) : id{id}, chunks(maxChunks), size{0}, dropped{0}
+                {
+                }
+
+                unsigned long id;
+                std::string name;
+                std::vector<std::unique_ptr<TraceEvent[]>> chunks;
+                std::atomic<size_t> size;
+                std::atomic<size_t> dropped;
+            };
+
+            // the buffers outlive their threads to keep the events for writing
+            std::mutex registryMutex;
+            std::vector<std::unique_ptr<ThreadBuffer>> registry;
+            thread_local ThreadBuffer *threadBuffer = nullptr;
+
+            ThreadBuffer* getThreadBuffer()
+            {
+                if(!threadBuffer)
+                {
+                    std::lock_guard<std::mutex> lock{registryMutex};
+                    registry.emplace_back(new ThreadBuffer{registry.size() + 1});
+                    threadBuffer = registry.back().get();
+                }
+                return threadBuffer;
+            }
+
+            uint64_t now()
+            {
+                return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now().time_since_epoch()).count();
+            }
+
+            void writeEscaped(FILE *file, const char *s)
+            {
+                for(; *s; ++s)
+                {
+                    if(*s == '"' || *s == '\\')
+                    {
+                        fputc('\\', file);
+                    }
+                    fputc(*s, file);
+                }
+            }
+        }
+
+        std::atomic<bool> Tracer::enabled{false};
+
+        void Tracer::start()
+        {
+            enabled.store(true, std::memory_order_relaxed);
+        }
+
+        void Tracer::stop()
+        {
+            enabled.store(false, std::memory_order_relaxed);
+        }
+
+        void Tracer::setThreadName(const std::string &name)
+        {
+            auto *buffer = getThreadBuffer();
+            std::lock_guard<std::mutex> lock{registryMutex};
+            buffer->name = name;
+        }
+
+        void Tracer::record(const char *name, char phase)
+        {
+            auto *buffer = getThreadBuffer();
+            const size_t index = buffer->size.load(std::memory_order_relaxed);
+            const size_t chunk = index / chunkSize;
+            if(chunk >= maxChunks)
+            {
+                buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            if(!buffer->chunks[chunk])
+            {
+                buffer->chunks[chunk].reset(new TraceEvent[chunkSize]);
+            }
+            buffer->chunks[chunk][index % chunkSize] = TraceEvent{name, now(), phase};
+            buffer->size.store(index + 1, std::memory_order_release);
+        }
+
+        bool Tracer::write(const std::string &filename)
+        {
+            FILE *file = fopen(filename.c_str(), "w");
+            if(!file)
+            {
+                return false;
+            }
+
+            std::lock_guard<std::mutex> lock{registryMutex};
+            fprintf(file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+            bool first = true;
+            for(const auto &buffer: registry)
+            {
+                if(!buffer->name.empty())
+                {
+                    fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%lu,\"args\":{\"name\":\"",
+                            first ? "" : ",\n", buffer->id);
+                    writeEscaped(file, buffer->name.c_str());
+                    fprintf(file, "\"}}");
+                    first = false;
+                }
+                const size_t size = buffer->size.load(std::memory_order_acquire);
+                for(size_t i = 0; i < size; ++i)
+                {
+                    const auto &event = buffer->chunks[i / chunkSize][i % chunkSize];
+                    fprintf(file, "%s{\"name\":\"", first ? "" : ",\n");
+                    writeEscaped(file, event.name);
+                    // the trace format expects microseconds
+                    fprintf(file, "\",\"ph\":\"%c\",\"pid\":1,\"tid\":%lu,\"ts\":%.3f}",
+                            event.phase, buffer->id, event.time*1e-3);
+                    first = false;
+                }
+                const size_t dropped = buffer->dropped.load(std::memory_order_relaxed);
+                if(dropped)
+                {
+                    fprintf(stderr, "Tracer: dropped %lu events of thread %lu\n",
+                            static_cast<unsigned long>(dropped), buffer->id);
+                }
+            }
+            fprintf(file, "\n]}\n");
+            fclose(file);
+            return true;
+        }
+
+        void Tracer::clear()
+        {
+            std::lock_guard<std::mutex> lock{registryMutex};
+            for(auto &buffer: registry)
+            {
+                buffer->size.store(0, std::memory_order_relaxed);
+                buffer->dropped.store(0, std::memory_order_relaxed);
+            }
+        }
+
+    } // end of namespace core
+} // end of namespace mars
@@ -0,0 +1,109 @@
+/**
+ * \file Tracer.hpp
+ * \brief Opt-in timeline of the simulation threads in the Chrome trace
+ * event format.
+ *
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+namespace mars
+{
+    namespace core
+    {
+        class TraceScope;
+
+        /**
+         * \brief Records begin/end events per thread and writes them as a
+         * Chrome/Perfetto JSON trace (chrome://tracing, ui.perfetto.dev).
+         *
+         * Every thread writes into its own buffer that only this thread
+         * modifies, so recording needs no lock. The buffers consist of
+         * fixed size chunks allocated on demand; once a thread reaches the
+         * maximum number of chunks further events of this thread are
+         * dropped. While tracing is disabled begin() and end() only load a
+         * flag.
+         *
+         * Event names are stored as pointers and have to stay valid until
+         * the trace is written, e.g. string literals.
+         */
+        class Tracer
+        {
+        public:
+            /** Starts recording. Events recorded before are kept. */
+            static void start();
+            static void stop();
+            static bool isEnabled()
+            {
+                return enabled.load(std::memory_order_relaxed);
+            }
+
+            static void begin(const char *name)
+            {
+                if(isEnabled())
+                {
+                    record(name, 'B');
+                }
+            }
+
+            static void end(const char *name)
+            {
+                if(isEnabled())
+                {
+                    record(name, 'E');
+                }
+            }
+
+            /** Names the calling thread in the trace. */
+            static void setThreadName(const std::string &name);
+
+            /**
+             * Writes all events recorded so far to the file. Events of
+             * threads that are still recording are cut at the point of the
+             * call. Returns false if the file cannot be written.
+             */
+            static bool write(const std::string &filename);
+
+            /** Drops all recorded events. No thread may record meanwhile. */
+            static void clear();
+
+        private:
+            friend class TraceScope;
+            static void record(const char *name, char phase);
+
+            static std::atomic<bool> enabled;
+        };
+
+        /**
+         * \brief Traces the lifetime of a scope as one slice.
+         */
+        class TraceScope
+        {
+        public:
+            explicit TraceScope(const char *name) : name{name}, active{Tracer::isEnabled()}
+            {
+                if(active)
+                {
+                    Tracer::begin(name);
+                }
+            }
+
+            ~TraceScope()
+            {
+                // always close a slice that was opened, even if tracing stopped meanwhile
+                if(active)
+                {
+                    Tracer::record(name, 'E');
+                }
+            }
+
+        private:
+            const char *name;
+            bool active;
+        };
+    } // end of namespace core
+} // end of namespace mars
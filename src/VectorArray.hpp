@@ -0,0 +1,50 @@
+/**
+ * \file VectorArray.hpp
+ * \brief Structure of arrays storage for 3d vectors used by batched queries.
+ *
+ */
+
+#pragma once
+
+#include <mars_utils/Vector.h>
+
+#include <vector>
+
+namespace mars
+{
+    namespace core
+    {
+        /**
+         * Stores n vectors as separate x, y and z arrays so batched queries
+         * can walk each component contiguously.
+         */
+        struct VectorArray
+        {
+            std::vector<double> x, y, z;
+
+            size_t size() const
+            {
+                return x.size();
+            }
+
+            void resize(size_t n)
+            {
+                x.resize(n);
+                y.resize(n);
+                z.resize(n);
+            }
+
+            void set(size_t i, const utils::Vector &v)
+            {
+                x[i] = v.x();
+                y[i] = v.y();
+                z[i] = v.z();
+            }
+
+            utils::Vector get(size_t i) const
+            {
+                return utils::Vector{x[i], y[i], z[i]};
+            }
+        };
+    } // end of namespace core
+} // end of namespace mars
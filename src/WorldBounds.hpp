@@ -0,0 +1,27 @@
+/**
+ * \file WorldBounds.hpp
+ * \brief Axis aligned bounds used to cull subworlds and collision items.
+ *
+ */
+
+#pragma once
+
+#include <mars_utils/Vector.h>
+
+namespace mars
+{
+    namespace core
+    {
+        /**
+         * Axis aligned box around the collision geometries of a subworld.
+         * An unbounded box (e.g. if the world contains a plane) is never
+         * culled, an empty box always is.
+         */
+        struct WorldBounds
+        {
+            utils::Vector min, max;
+            bool empty = true;
+            bool bounded = true;
+        };
+    } // end of namespace core
+} // end of namespace mars
@@ -0,0 +1,22 @@
+#include "ContactPluginScope.hpp"
+#include <envire_core/plugin/Plugin.hpp>
+
+#include <boost/serialization/string.hpp>
+#include <boost/serialization/vector.hpp>
+
+
+namespace boost
+{
+    namespace serialization
+    {
+
+        template<class Archive> inline void serialize(Archive & ar, mars::core::ContactPluginScope & value, const unsigned int file_version)
+        {
+            ar & value.frames;
+            ar & value.priority;
+        }
+
+    }
+}
+
+ENVIRE_REGISTER_ITEM(mars::core::ContactPluginScope)
@@ -0,0 +1,148 @@
+#include "SimulationCheckpoint.hpp"
+
+#include <boost/archive/binary_iarchive.hpp>
+#include <boost/archive/binary_oarchive.hpp>
+#include <boost/serialization/map.hpp>
+#include <boost/serialization/string.hpp>
+#include <boost/serialization/vector.hpp>
+
+#include <fstream>
+
+
+namespace boost
+{
+    namespace serialization
+    {
+
+        template<class Archive> inline void serialize(Archive & ar, mars::utils::Vector & value, const unsigned int file_version)
+        {
+            ar & value.x();
+            ar & value.y();
+            ar & value.z();
+        }
+
+        template<class Archive> inline void serialize(Archive & ar, mars::utils::Quaternion & value, const unsigned int file_version)
+        {
+            ar & value.w();
+            ar & value.x();
+            ar & value.y();
+            ar & value.z();
+        }
+
+        // only the state of the controller, the gains are kept on restore
+        template<class Archive> inline void serialize(Archive & ar, mars::core::PID & value, const unsigned int file_version)
+        {
+            ar & value.last_value;
+            ar & value.last_error;
+            ar & value.last_i;
+            ar & value.current_value;
+            ar & value.target_value;
+            ar & value.output_value;
+        }
+
+        template<class Archive> inline void serialize(Archive & ar, mars::core::SimMotor::State & value, const unsigned int file_version)
+        {
+            ar & value.time;
+            ar & value.lastVelocity;
+            ar & value.velocity;
+            ar & value.position1;
+            ar & value.position2;
+            ar & value.effort;
+            ar & value.sensedEffort;
+            ar & value.current;
+            ar & value.temperature;
+            ar & value.feedForwardEffort;
+            ar & value.feedForwardEffortIntern;
+            ar & value.controlValue;
+            ar & value.last_error;
+            ar & value.integ_error;
+            ar & value.joint_velocity;
+            ar & value.error;
+            ar & value.posPID;
+            ar & value.velPID;
+        }
+
+        template<class Archive> inline void serialize(Archive & ar, mars::core::SimulationCheckpoint::BodyState & value, const unsigned int file_version)
+        {
+            ar & value.frame;
+            ar & value.position;
+            ar & value.rotation;
+            ar & value.linearVelocity;
+            ar & value.angularVelocity;
+        }
+
+        template<class Archive> inline void serialize(Archive & ar, mars::core::SimulationCheckpoint::JointState & value, const unsigned int file_version)
+        {
+            ar & value.name;
+            ar & value.position;
+            ar & value.velocity;
+        }
+
+        template<class Archive> inline void serialize(Archive & ar, mars::core::SimulationCheckpoint & value, const unsigned int file_version)
+        {
+            ar & value.simTime;
+            ar & value.bodies;
+            ar & value.joints;
+            ar & value.motors;
+        }
+
+    }
+}
+
+namespace mars
+{
+    namespace core
+    {
+
+        static const std::string checkpointFileTag{"mars_core checkpoint"};
+        static const unsigned int checkpointFileVersion = 1;
+
+        bool writeCheckpoint(const SimulationCheckpoint &checkpoint, const std::string &filename)
+        {
+            std::ofstream file{filename, std::ios::binary};
+            if(!file)
+            {
+                return false;
+            }
+            try
+            {
+                // the archive writes its trailer when it is destroyed
+                boost::archive::binary_oarchive archive{file};
+                archive << checkpointFileTag << checkpointFileVersion << checkpoint;
+            }
+            catch(const boost::archive::archive_exception&)
+            {
+                return false;
+            }
+            file.close();
+            return !file.fail();
+        }
+
+        bool readCheckpoint(const std::string &filename, SimulationCheckpoint *checkpoint)
+        {
+            std::ifstream file{filename, std::ios::binary};
+            if(!file)
+            {
+                return false;
+            }
+            try
+            {
+                boost::archive::binary_iarchive archive{file};
+                std::string tag;
+                unsigned int version;
+                archive >> tag >> version;
+                if(tag != checkpointFileTag || version != checkpointFileVersion)
+                {
+                    return false;
+                }
+                archive >> *checkpoint;
+            }
+            catch(const boost::archive::archive_exception&)
+            {
+                return false;
+            }
+            return true;
+        }
+
+    }
+}
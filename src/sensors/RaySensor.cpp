@@ -6,6 +6,7 @@
  */
 
 #include "RaySensor.hpp"
+#include "../Tracer.hpp"
 
 #include <mars_utils/mathUtils.h>
 #include <mars_interfaces/sim/SimulatorInterface.h>
@@ -27,18 +28,19 @@ namespace mars
         using namespace configmaps;
         using namespace interfaces;
 
-        BaseSensor* RaySensor::instanciate(ControlCenter *control, BaseConfig *config )
+        BaseSensor* RaySensor::instanciate(ControlCenter *control, BaseConfig *config,
+                                           RayCaster *rayCaster)
         {
             RayConfig *cfg = dynamic_cast<RayConfig*>(config);
             assert(cfg);
-            return new RaySensor(control,*cfg);
+            return new RaySensor(control,*cfg,rayCaster);
         }
 
-        RaySensor::RaySensor(ControlCenter *control, RayConfig config):
+        RaySensor::RaySensor(ControlCenter *control, RayConfig config, RayCaster *rayCaster):
             BasePolarIntersectionSensor(config.id, config.name, config.width,
                                         config.height, config.opening_width,
                                         config.opening_height),
-            SensorInterface(control), config(config)
+            SensorInterface(control), config(config), rayCaster(rayCaster)
         {
             updateRate = config.updateRate;
             maxDistance = config.maxDistance;
@@ -53,10 +55,6 @@ namespace mars
             for(int i = 0; i < 4; ++i)
                 rotationIndices[i] = -1;
 
-            if(control->dataBroker->registerTimedReceiver(this, config.groupName, config.dataName,"mars_sim/simTimer",updateRate))
-            {
-            }
-
             fprintf(stderr, "RaySensor init pos: %g %g %g\n", config.init_position.x(), config.init_position.y(), config.init_position.z());
             position = config.init_position + config.init_orientation*config.pos_offset;
             orientation = config.init_orientation * config.ori_offset;
@@ -108,9 +106,20 @@ namespace mars
 
                 assert(rad_steps == data.size());
             }
+
+            rayOrigins.resize(directions.size());
+            rayDirections.resize(directions.size());
+            distances.resize(directions.size());
+
             // todo: need more intelligent solution: maybe generate data only on demand?
             //       or move it to seperated thread depending on performance
             deactivate = true;
+
+            // receiveData() may run as soon as the receiver is registered,
+            // so all buffers have to be sized before
+            if(control->dataBroker->registerTimedReceiver(this, config.groupName, config.dataName,"mars_sim/simTimer",updateRate))
+            {
+            }
         }
 
         RaySensor::~RaySensor(void)
@@ -153,10 +162,16 @@ namespace mars
             return data.size();
         }
 
+        SensorDataView RaySensor::getSensorDataView() const
+        {
+            return distanceData.getView();
+        }
+
         void RaySensor::receiveData(const data_broker::DataInfo &info,
                                     const data_broker::DataPackage &package,
                                     int callbackParam)
         {
+            TraceScope trace{"RaySensor::receiveData"};
             CPP_UNUSED(info);
             CPP_UNUSED(callbackParam);
             long id;
@@ -187,12 +202,38 @@ namespace mars
             if(!deactivate)
             {
                 Vector tmp;
-                for(size_t i=0; i<directions.size(); i++)
+                if(rayCaster)
+                {
+                    for(size_t i=0; i<directions.size(); i++)
+                    {
+                        tmp = orientation * directions[i];
+                        tmp *= config.maxDistance;
+                        rayOrigins.set(i, position);
+                        rayDirections.set(i, tmp);
+                    }
+                    rayCaster->getVectorCollisions(rayOrigins, rayDirections, distances.data(),
+                                                   config.parallel_rays);
+                    for(size_t i=0; i<directions.size(); i++)
+                    {
+                        data[i] = distances[i];
+                    }
+                }
+                else
+                {
+                    for(size_t i=0; i<directions.size(); i++)
+                    {
+                        tmp = orientation * directions[i];
+                        tmp *= config.maxDistance;
+                        data[i] = control->sim->getVectorCollision(position, tmp);
+                    }
+                }
+
+                auto &published = distanceData.beginWrite(data.size());
+                for(size_t i=0; i<data.size(); i++)
                 {
-                    tmp = orientation * directions[i];
-                    tmp *= config.maxDistance;
-                    data[i] = control->sim->getVectorCollision(position, tmp);
+                    published[i] = data[i];
                 }
+                distanceData.publish();
             }
         }
 
@@ -231,6 +272,8 @@ namespace mars
                 cfg->maxDistance = it->second;
             if((it = config->find("draw_rays")) != config->end())
                 cfg->draw_rays = it->second;
+            if((it = config->find("parallel_rays")) != config->end())
+                cfg->parallel_rays = it->second;
             if((it = config->find("rate")) != config->end())
                 cfg->updateRate = it->second;
 
@@ -284,6 +327,7 @@ namespace mars
             cfg["opening_width"] = config.opening_width;
             cfg["max_distance"] = config.maxDistance;
             cfg["draw_rays"] = config.draw_rays;
+            cfg["parallel_rays"] = config.parallel_rays;
             cfg["rate"] = config.updateRate;
             /*
               cfg["stepX"] = config.stepX;
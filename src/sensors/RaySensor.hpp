@@ -13,6 +13,10 @@
 #include <mars_utils/Quaternion.h>
 #include <mars_interfaces/graphics/draw_structs.h>
 
+#include "../RayCaster.hpp"
+#include "../VectorArray.hpp"
+#include "../SensorDataView.hpp"
+
 namespace mars
 {
     namespace core
@@ -35,6 +39,7 @@ namespace mars
                     attached_node = 0;
                     maxDistance = 100.0;
                     draw_rays = true;
+                    parallel_rays = false;
                 }
 
             unsigned long attached_node;
@@ -46,6 +51,7 @@ namespace mars
             double opening_height;
             double maxDistance;
             bool draw_rays;
+            bool parallel_rays; // split the rays into chunks cast on the ray pool of the simulator
             std::string groupName, dataName;
         };
 
@@ -53,17 +59,24 @@ namespace mars
             public interfaces::BasePolarIntersectionSensor ,
             public interfaces::SensorInterface,
             public data_broker::ReceiverInterface,
-            public interfaces::DrawInterface
+            public interfaces::DrawInterface,
+            public SensorDataProvider
         {
 
         public:
+            /**
+             * The rays are cast with the given caster in one batch per
+             * update, without caster one by one via ControlCenter::sim.
+             */
             static interfaces::BaseSensor* instanciate(interfaces::ControlCenter *control,
-                                                       interfaces::BaseConfig* config);
-            RaySensor(interfaces::ControlCenter *control, RayConfig config);
+                                                       interfaces::BaseConfig* config,
+                                                       RayCaster *rayCaster);
+            RaySensor(interfaces::ControlCenter *control, RayConfig config, RayCaster *rayCaster);
             ~RaySensor(void);
 
             std::vector<double> getSensorData() const;
             int getSensorData(double**) const;
+            SensorDataView getSensorDataView() const override;
             virtual void receiveData(const data_broker::DataInfo &info,
                                      const data_broker::DataPackage &package,
                                      int callbackParam);
@@ -83,6 +96,12 @@ namespace mars
             mutable bool deactivate;
             long positionIndices[3];
             long rotationIndices[4];
+
+            // buffers for the batched collision query
+            RayCaster *rayCaster;
+            VectorArray rayOrigins, rayDirections;
+            std::vector<interfaces::sReal> distances;
+            SensorDataBuffer distanceData; ///< the distances of the last update
         };
 
     } // end of namespace core
@@ -6,6 +6,7 @@
  */
 
 #include "RotatingRaySensor.hpp"
+#include "../Tracer.hpp"
 
 #include <mars_interfaces/sim/NodeManagerInterface.h>
 #include <mars_interfaces/sim/SimulatorInterface.h>
@@ -17,9 +18,11 @@
 #include <cfg_manager/CFGManagerInterface.h>
 #include <mars_utils/MutexLocker.h>
 
+#include <algorithm>
 #include <cmath>
 #include <cstdio>
 #include <cstdlib>
+#include <utility>
 
 namespace mars {
   namespace core {
@@ -28,13 +31,15 @@ namespace mars {
     using namespace configmaps;
     using namespace interfaces;
 
-    BaseSensor* RotatingRaySensor::instanciate(ControlCenter *control, BaseConfig *config ){
+    BaseSensor* RotatingRaySensor::instanciate(ControlCenter *control, BaseConfig *config,
+                                               RayCaster *rayCaster){
       RotatingRayConfig *cfg = dynamic_cast<RotatingRayConfig*>(config);
       assert(cfg);
-      return new RotatingRaySensor(control,*cfg);
+      return new RotatingRaySensor(control,*cfg,rayCaster);
     }
 
-    RotatingRaySensor::RotatingRaySensor(ControlCenter *control, RotatingRayConfig config):
+    RotatingRaySensor::RotatingRaySensor(ControlCenter *control, RotatingRayConfig config,
+                                         RayCaster *rayCaster):
       BasePolarIntersectionSensor(config.id,
                                   config.name,
                                   config.bands*config.lasers,
@@ -42,7 +47,8 @@ namespace mars {
                                   config.opening_width,
                                   config.opening_height),
       SensorInterface(control),
-      config(config) {
+      config(config),
+      rayCaster(rayCaster) {
 
       updateRate = config.updateRate;
       orientation.setIdentity();
@@ -50,12 +56,12 @@ namespace mars {
       cloud_offset_v = 0.0;
       cloud_offset_h = 0.0;
       turning_offset = 0.0;
-      full_scan = false;
+      pointcloud_sequence = 0;
       current_pose.setIdentity();
       num_points = 0;
       toCloud = &pointcloud1;
+      fromCloud = &pointcloud2;
       convertPointCloud = false;
-      nextCloud = 2;
       this->attached_node = config.attached_node;
 
       std::string groupName, dataName;
@@ -69,9 +75,6 @@ namespace mars {
       for(int i = 0; i < 4; ++i)
         rotationIndices[i] = -1;
 
-      if(control->dataBroker->registerTimedReceiver(this, config.groupName, config.dataName,"mars_sim/simTimer",updateRate)) {
-      }
-
       //position = control->nodes->getPosition(attached_node);
       //orientation = control->nodes->getRotation(attached_node);
       //orientation_offset.setIdentity();
@@ -142,8 +145,29 @@ namespace mars {
           control->graphics->addDrawItems(&draw);
         }
       }
+      // Each receiveData() adds at most bands*lasers points and a scan lasts
+      // until the turning offset passes turning_end_fullscan.
+      size_t steps = 1;
+      if(turning_step > 0.0) {
+        steps += (size_t)std::ceil(turning_end_fullscan / turning_step);
+      }
+      const size_t scanCapacity = directions.size() * steps;
+      pointcloud1.points.resize(scanCapacity);
+      pointcloud1.size = 0;
+      pointcloud2.points.resize(scanCapacity);
+      pointcloud2.size = 0;
+
+      rayOrigins.resize(directions.size());
+      rayDirections.resize(directions.size());
+      distances.resize(directions.size());
+
       closeThread = false;
       this->start();
+
+      // receiveData() may run as soon as the receiver is registered, so all
+      // buffers have to be sized before
+      if(control->dataBroker->registerTimedReceiver(this, config.groupName, config.dataName,"mars_sim/simTimer",updateRate)) {
+      }
     }
 
     RotatingRaySensor::~RotatingRaySensor(void) {
@@ -151,36 +175,44 @@ namespace mars {
         control->graphics->removeDrawItems((DrawInterface*)this);
       if (control->dataBroker)
         control->dataBroker->unregisterTimedReceiver(this, "*", "*", "mars_sim/simTimer");
+      handoffMutex.lock();
       closeThread = true;
+      scanReady.wakeAll();
+      scanConverted.wakeAll();
+      handoffMutex.unlock();
       this->wait();
     }
 
     bool RotatingRaySensor::getPointcloud(std::vector<utils::Vector>& pcloud) {
-      mars::utils::MutexLocker lock(&mutex_pointcloud);
-      if(full_scan) {
-        full_scan = false;
-        pcloud.swap(pointcloud_full);
-        return true;
-      } else {
+      const SensorDataView view = pointcloud_data.getView();
+      if(view.sequence == pointcloud_sequence) {
         return false;
       }
+      pointcloud_sequence = view.sequence;
+      const size_t n = view.size()/3;
+      pcloud.resize(n);
+      for(size_t i=0; i<n; i++) {
+        pcloud[i] = utils::Vector(view.data()[i*3], view.data()[i*3+1], view.data()[i*3+2]);
+      }
+      return true;
     }
 
     int RotatingRaySensor::getSensorData(double** data_) const {
-      mars::utils::MutexLocker lock(&mutex_pointcloud);
-      *data_ = (double*)malloc(pointcloud_full.size()*3*sizeof(double));
-      for(unsigned int i=0; i<pointcloud_full.size(); i++) {
-        int array_pos = i*3;
-        (*data_)[array_pos] = (pointcloud_full[i])[0];
-        (*data_)[array_pos+1] = (pointcloud_full[i])[1];
-        (*data_)[array_pos+2] = (pointcloud_full[i])[2];
-      }
-      return pointcloud_full.size()*3;
+      // compatibility path, getSensorDataView() provides the data without copying
+      const SensorDataView view = pointcloud_data.getView();
+      *data_ = (double*)malloc(view.size()*sizeof(double));
+      std::copy(view.data(), view.data() + view.size(), *data_);
+      return view.size();
+    }
+
+    SensorDataView RotatingRaySensor::getSensorDataView() const {
+      return pointcloud_data.getView();
     }
 
     void RotatingRaySensor::receiveData(const data_broker::DataInfo &info,
                                         const data_broker::DataPackage &package,
                                         int callbackParam) {
+      TraceScope trace{"RotatingRaySensor::receiveData"};
       CPP_UNUSED(info);
       CPP_UNUSED(callbackParam);
       long id;
@@ -220,12 +252,26 @@ namespace mars {
 
       turn();
       Vector tmp;
-      for(size_t i=0; i<directions.size(); i++)
-      {
+      if(rayCaster) {
+        for(size_t i=0; i<directions.size(); i++) {
           // todo: handle rotation of bands
+          tmp = orientation * orientation_offset * directions[i];
+          tmp *= config.maxDistance;
+          rayOrigins.set(i, position);
+          rayDirections.set(i, tmp);
+        }
+        rayCaster->getVectorCollisions(rayOrigins, rayDirections, distances.data(),
+                                       config.parallel_rays);
+        for(size_t i=0; i<directions.size(); i++) {
+          data[i] = distances[i];
+        }
+      }
+      else {
+        for(size_t i=0; i<directions.size(); i++) {
           tmp = orientation * orientation_offset * directions[i];
           tmp *= config.maxDistance;
           data[i] = control->sim->getVectorCollision(position, tmp);
+        }
       }
 
       int i = 0; // data_counter
@@ -245,7 +291,11 @@ namespace mars {
             // Gathers pointcloud in the world frame to prevent/reduce movement distortion.
             // This necessitates a back-transformation (world2node) in getPointcloud().
             tmpvec = current_pose * local_ray;
-            toCloud->push_back(tmpvec); // Scale normalized vector.
+            if(toCloud->size == toCloud->points.size()) {
+              // only happens if the scan takes more steps than expected
+              toCloud->points.resize(2*toCloud->size + directions.size());
+            }
+            toCloud->points.set(toCloud->size++, tmpvec);
           }
         }
       }
@@ -279,21 +329,20 @@ namespace mars {
 
     utils::Quaternion RotatingRaySensor::turn() {
 
-      // If the scan is full the pointcloud will be copied.
-      mutex_pointcloud.lock();
+      // If the scan is full the pointcloud is handed to the conversion thread.
       turning_offset += turning_step;
       if(turning_offset >= turning_end_fullscan) {
-        while(convertPointCloud) msleep(1);
-        fromCloud = toCloud;
-        if(nextCloud == 2) {
-          toCloud = &pointcloud2;
-          nextCloud = 1;
-        }
-        else {
-          toCloud = &pointcloud1;
-          nextCloud = 2;
+        // waits only if the previous scan is still being converted
+        TraceScope trace{"RotatingRaySensor::handoff"};
+        handoffMutex.lock();
+        while(convertPointCloud && !closeThread) {
+          scanConverted.wait(&handoffMutex);
         }
+        std::swap(toCloud, fromCloud);
         convertPointCloud = true;
+        scanReady.wakeAll();
+        handoffMutex.unlock();
+
         double vAngle = config.lasers <= 1 ? config.opening_height/2.0 : config.opening_height/(config.lasers-1);
         double hAngle = config.bands <= 1 ? 0 : config.opening_width/config.bands;
         cloud_offset_h += config.cloud_offset;
@@ -325,7 +374,6 @@ namespace mars {
         }
       }
       orientation_offset = utils::angleAxisToQuaternion(turning_offset, utils::Vector(0.0, 0.0, 1.0));
-      mutex_pointcloud.unlock();
 
       return orientation_offset;
     }
@@ -335,36 +383,49 @@ namespace mars {
     }
 
     void RotatingRaySensor::run() {
+      Tracer::setThreadName("RotatingRaySensor " + config.name);
+      handoffMutex.lock();
       while(!closeThread) {
-        if(convertPointCloud) {
+        if(!convertPointCloud) {
+          scanReady.wait(&handoffMutex);
+          continue;
+        }
+        // turn() does not touch fromCloud while convertPointCloud is set
+        handoffMutex.unlock();
+        {
+          TraceScope trace{"RotatingRaySensor::convert"};
           poseMutex.lock();
-          Eigen::Affine3d current_pose2 = current_pose;
           Eigen::Affine3d rot;
           rot.setIdentity();
           rot.rotate(config.transf_sensor_rot_to_sensor);
+          // Transforms the pointcloud back from world to current node (see receiveDate()).
+          // In addition 'transf_sensor_rot_to_sensor' is applied which describes
+          // the orientation of the sensor in the unturned sensor frame.
+          const Eigen::Affine3d transform = rot * current_pose.inverse();
           poseMutex.unlock();
 
-          // Copies current full pointcloud to pointcloud_full.
-          std::list<utils::Vector>::iterator it = fromCloud->begin();
-          mutex_pointcloud.lock();
-          pointcloud_full.clear();
-          pointcloud_full.reserve(fromCloud->size());
-          base::Vector3d vec_local;
-
-          for(int i=0; it != fromCloud->end(); it++, i++) {
-            // Transforms the pointcloud back from world to current node (see receiveDate()).
-            // In addition 'transf_sensor_rot_to_sensor' is applied which describes
-            // the orientation of the sensor in the unturned sensor frame.
-            vec_local = rot * current_pose2.inverse() * (*it);
-            pointcloud_full.push_back(vec_local);
+          const Eigen::Matrix3d r = transform.linear();
+          const Eigen::Vector3d t = transform.translation();
+          const size_t n = fromCloud->size;
+          const double *x = fromCloud->points.x.data();
+          const double *y = fromCloud->points.y.data();
+          const double *z = fromCloud->points.z.data();
+
+          // the buffer is reused unless a reader still holds a view on it
+          std::vector<double> &out = pointcloud_data.beginWrite(3*n);
+          for(size_t i=0; i<n; ++i) {
+            out[i*3]   = r(0,0)*x[i] + r(0,1)*y[i] + r(0,2)*z[i] + t.x();
+            out[i*3+1] = r(1,0)*x[i] + r(1,1)*y[i] + r(1,2)*z[i] + t.y();
+            out[i*3+2] = r(2,0)*x[i] + r(2,1)*y[i] + r(2,2)*z[i] + t.z();
           }
-          mutex_pointcloud.unlock();
-          fromCloud->clear();
-          convertPointCloud = false;
-          full_scan = true;
+          fromCloud->size = 0;
+          pointcloud_data.publish();
         }
-        else msleep(2);
+        handoffMutex.lock();
+        convertPointCloud = false;
+        scanConverted.wakeAll();
       }
+      handoffMutex.unlock();
     }
 
     BaseConfig* RotatingRaySensor::parseConfig(ControlCenter *control,
@@ -393,6 +454,8 @@ namespace mars {
         cfg->minDistance = it->second;
       if((it = config->find("draw_rays")) != config->end())
         cfg->draw_rays = it->second;
+      if((it = config->find("parallel_rays")) != config->end())
+        cfg->parallel_rays = it->second;
       if((it = config->find("horizontal_offset")) != config->end())
         cfg->horizontal_offset = it->second;
       if((it = config->find("vertical_offset")) != config->end())
@@ -442,6 +505,7 @@ namespace mars {
       cfg["max_distance"] = config.maxDistance;
       cfg["min_distance"] = config.minDistance;
       cfg["draw_rays"] = config.draw_rays;
+      cfg["parallel_rays"] = config.parallel_rays;
       cfg["vertical_offset"] = config.vertical_offset;
       cfg["horizontal_offset"] = config.horizontal_offset;
       cfg["rate"] = config.updateRate;
@@ -14,10 +14,15 @@
 #include <mars_utils/Thread.h>
 #include <mars_utils/mathUtils.h>
 #include <mars_utils/Mutex.h>
+#include <mars_utils/WaitCondition.h>
 #include <mars_interfaces/graphics/draw_structs.h>
 
 #include <base/Pose.hpp>
 
+#include "../RayCaster.hpp"
+#include "../VectorArray.hpp"
+#include "../SensorDataView.hpp"
+
 namespace mars {
   namespace core {
 
@@ -37,6 +42,7 @@ namespace mars {
         minDistance = 0.01;
         maxDistance = 100.0;
         draw_rays = true;
+        parallel_rays = false;
         horizontal_resolution = (1.0/180.0)*M_PI;
         transf_sensor_rot_to_sensor.setIdentity();
         horizontal_offset = 0.0;
@@ -56,6 +62,7 @@ namespace mars {
       double minDistance;
       double maxDistance;
       bool draw_rays;
+      bool parallel_rays; // split the rays into chunks cast on the ray pool of the simulator
       std::string groupName, dataName;
       double horizontal_resolution;
       double cloud_offset;
@@ -71,12 +78,19 @@ namespace mars {
       public interfaces::SensorInterface, // Stores the ControlCenter* control pointer.
       public data_broker::ReceiverInterface,
       public interfaces::DrawInterface,
+      public SensorDataProvider,
       mars::utils::Thread {
 
     public:
+      /**
+       * The rays are cast with the given caster in one batch per update,
+       * without caster one by one via ControlCenter::sim.
+       */
       static interfaces::BaseSensor* instanciate(interfaces::ControlCenter *control,
-                                                 interfaces::BaseConfig* config);
-      RotatingRaySensor(interfaces::ControlCenter *control, RotatingRayConfig config);
+                                                 interfaces::BaseConfig* config,
+                                                 RayCaster *rayCaster);
+      RotatingRaySensor(interfaces::ControlCenter *control, RotatingRayConfig config,
+                        RayCaster *rayCaster);
       ~RotatingRaySensor(void);
       
       /**
@@ -84,7 +98,8 @@ namespace mars {
        * The pointcloud is gathered within the world frame and
        * - after a complete scan has been received - transformed into the
        * current local frame. This prevents strong distortions on slower computers.
-       * If a full scan is not available an empty pointcloud will be returned.
+       * Returns false and leaves the pointcloud untouched if no new full
+       * scan is available since the last call.
        */
       bool getPointcloud(std::vector<utils::Vector>& pointcloud);
 
@@ -94,6 +109,11 @@ namespace mars {
        * Inherited from BaseSensor, implemented from BasePolarIntersectionSensor.
        */
       int getSensorData(double**) const; 
+
+      /**
+       * Returns the current full pointcloud as (x,y,z) triples without copying.
+       */
+      SensorDataView getSensorDataView() const override;
       
       /**
        * Receives the measured distances, calculates the vectors in the local
@@ -128,10 +148,10 @@ namespace mars {
       /**
        * Turns the sensor during each simulation step.
        * As soon as a full scan has been done (depends on the number of bands)
-       * the pointcloud is copied to pointcloud_full and a new scan
-       * is initiated. Runs in the same thread than receiveData, so only the use of 
-       * full_pointcloud (turn(), getPointcloud() and getSensorData()) has to be 
-       * synchronized.
+       * the pointcloud is handed to the conversion thread and a new scan
+       * is initiated. Runs in the same thread than receiveData. The finished
+       * scan is handed to the conversion thread under handoffMutex; turn()
+       * only blocks if the previous scan is still being converted.
        */
       utils::Quaternion turn();
       
@@ -151,20 +171,23 @@ namespace mars {
       void run();
 
     private:
+      /** Points of one scan in world coordinates, preallocated for a full scan. */
+      struct ScanBuffer {
+        VectorArray points;
+        size_t size;
+      };
+
       /** Contains the normalized scan directions. */ 
       std::vector<utils::Vector> directions;
-      // TODO Storing the pointcloud four times is not very effective.
       // Maybe: Integrate distortion-prevention (use current sensor pose)
       // in mlls and only create the pointcloud on demand.
-      std::list<utils::Vector> pointcloud1; // TODO Replace with array with fix size.
-      std::list<utils::Vector> pointcloud2; // TODO Replace with array with fix size.
-      std::list<utils::Vector> *toCloud, *fromCloud; // TODO Replace with array with fix size.
-      std::vector<utils::Vector> pointcloud_full; // Stores the full scan.
-      bool convertPointCloud;
-      int nextCloud;
+      ScanBuffer pointcloud1, pointcloud2;
+      ScanBuffer *toCloud, *fromCloud; // swapped by turn() after a full scan
+      SensorDataBuffer pointcloud_data; // the last full scan as (x,y,z) triples
+      unsigned long pointcloud_sequence; // last scan returned by getPointcloud()
+      bool convertPointCloud; // fromCloud is owned by run() while set
       double vertical_resolution;
       bool update_available;
-      bool full_scan;
       double turning_offset, cloud_offset_v, cloud_offset_h;
       double turning_end_fullscan; // Defines the upper border for the turning_offset. 
       utils::Quaternion orientation_offset; // Used to turn the sensor during each simulation step.
@@ -172,10 +195,18 @@ namespace mars {
       long rotationIndices[4];
       double turning_step;
       int nsamples;
-      mutable mars::utils::Mutex mutex_pointcloud, poseMutex;
+      mutable mars::utils::Mutex poseMutex;
       Eigen::Affine3d current_pose;
       bool closeThread;
+      // protects convertPointCloud and closeThread
+      mars::utils::Mutex handoffMutex;
+      mars::utils::WaitCondition scanReady, scanConverted;
       unsigned int num_points;
+
+      // buffers for the batched collision query
+      RayCaster *rayCaster;
+      VectorArray rayOrigins, rayDirections;
+      std::vector<interfaces::sReal> distances;
     };
 
   } // end of namespace sim
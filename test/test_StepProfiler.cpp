@@ -0,0 +1,90 @@
+/**
+ * \file test_StepProfiler.cpp
+ * \brief Tests of the latency histograms of the StepProfiler.
+ *
+ */
+
+#define BOOST_TEST_MODULE StepProfiler
+#include <boost/test/unit_test.hpp>
+
+#include <StepProfiler.hpp>
+
+#include <limits>
+
+using mars::core::StepProfiler;
+
+BOOST_AUTO_TEST_CASE(phases_are_created_once)
+{
+    StepProfiler profiler;
+    const size_t a = profiler.addPhase("a");
+    const size_t b = profiler.addPhase("b");
+    BOOST_CHECK_NE(a, b);
+    BOOST_CHECK_EQUAL(profiler.addPhase("a"), a);
+    const auto statistics = profiler.getStatistics();
+    BOOST_REQUIRE_EQUAL(statistics.size(), 2u);
+    BOOST_CHECK_EQUAL(statistics[0].name, "a");
+    BOOST_CHECK_EQUAL(statistics[1].name, "b");
+    BOOST_CHECK_EQUAL(statistics[0].count, 0u);
+    BOOST_CHECK_EQUAL(statistics[0].p50, 0u);
+}
+
+BOOST_AUTO_TEST_CASE(small_values_are_exact)
+{
+    StepProfiler profiler;
+    const size_t phase = profiler.addPhase("phase");
+    for(uint64_t i = 1; i <= 10; ++i)
+    {
+        profiler.record(phase, i);
+    }
+    const auto s = profiler.getStatistics()[0];
+    BOOST_CHECK_EQUAL(s.count, 10u);
+    BOOST_CHECK_EQUAL(s.p50, 5u);
+    BOOST_CHECK_EQUAL(s.p99, 10u);
+    BOOST_CHECK_EQUAL(s.max, 10u);
+    BOOST_CHECK_CLOSE(s.mean, 5.5, 1e-9);
+}
+
+// the reported percentiles are at most 1/16 above the real value
+BOOST_AUTO_TEST_CASE(percentiles_are_bounded_by_the_bucket_width)
+{
+    StepProfiler profiler;
+    const size_t phase = profiler.addPhase("phase");
+    for(uint64_t i = 1; i <= 100000; ++i)
+    {
+        profiler.record(phase, i*1000);
+    }
+    const auto s = profiler.getStatistics()[0];
+    const double p50 = 50000*1000.0, p99 = 99000*1000.0;
+    BOOST_CHECK_GE(s.p50, p50);
+    BOOST_CHECK_LE(s.p50, p50*(1.0 + 1.0/16));
+    BOOST_CHECK_GE(s.p99, p99);
+    BOOST_CHECK_LE(s.p99, p99*(1.0 + 1.0/16));
+    BOOST_CHECK_EQUAL(s.max, 100000u*1000u);
+}
+
+BOOST_AUTO_TEST_CASE(largest_values_are_recorded)
+{
+    StepProfiler profiler;
+    const size_t phase = profiler.addPhase("phase");
+    const uint64_t largest = std::numeric_limits<uint64_t>::max();
+    profiler.record(phase, largest);
+    const auto s = profiler.getStatistics()[0];
+    BOOST_CHECK_EQUAL(s.p50, largest);
+    BOOST_CHECK_EQUAL(s.max, largest);
+}
+
+BOOST_AUTO_TEST_CASE(reset_keeps_the_phases)
+{
+    StepProfiler profiler;
+    const size_t phase = profiler.addPhase("phase");
+    profiler.record(phase, 42);
+    profiler.reset();
+    BOOST_CHECK_EQUAL(profiler.addPhase("phase"), phase);
+    auto s = profiler.getStatistics()[0];
+    BOOST_CHECK_EQUAL(s.count, 0u);
+    BOOST_CHECK_EQUAL(s.max, 0u);
+    profiler.record(phase, 7);
+    s = profiler.getStatistics()[0];
+    BOOST_CHECK_EQUAL(s.count, 1u);
+    BOOST_CHECK_EQUAL(s.p50, 7u);
+}
@@ -0,0 +1,148 @@
+/**
+ * \file test_SweepAndPrune.cpp
+ * \brief Tests of the broadphase between the collision items.
+ *
+ */
+
+#define BOOST_TEST_MODULE SweepAndPrune
+#include <boost/test/unit_test.hpp>
+
+#include <SweepAndPrune.hpp>
+
+#include <limits>
+#include <random>
+
+using mars::core::SweepAndPrune;
+using mars::core::WorldBounds;
+using mars::utils::Vector;
+using Pairs = std::vector<std::pair<size_t, size_t>>;
+
+namespace
+{
+    WorldBounds box(const Vector &min, const Vector &max)
+    {
+        WorldBounds bounds;
+        bounds.min = min;
+        bounds.max = max;
+        bounds.empty = false;
+        return bounds;
+    }
+
+    WorldBounds cube(const Vector &center, double halfExtent)
+    {
+        return box(center - Vector::Constant(halfExtent), center + Vector::Constant(halfExtent));
+    }
+
+    bool overlap(const WorldBounds &a, const WorldBounds &b)
+    {
+        return (a.min.array() <= b.max.array()).all() && (b.min.array() <= a.max.array()).all();
+    }
+}
+
+BOOST_AUTO_TEST_CASE(items_are_unbounded_after_resize)
+{
+    SweepAndPrune broadphase;
+    broadphase.resize(3);
+    Pairs pairs;
+    broadphase.findOverlappingPairs(&pairs);
+    BOOST_CHECK(pairs == (Pairs{{0, 1}, {0, 2}, {1, 2}}));
+}
+
+BOOST_AUTO_TEST_CASE(empty_items_never_overlap)
+{
+    SweepAndPrune broadphase;
+    broadphase.resize(3);
+    broadphase.setBounds(1, WorldBounds{});
+    Pairs pairs;
+    broadphase.findOverlappingPairs(&pairs);
+    BOOST_CHECK(pairs == (Pairs{{0, 2}}));
+}
+
+BOOST_AUTO_TEST_CASE(touching_bounds_overlap)
+{
+    SweepAndPrune broadphase;
+    broadphase.resize(3);
+    broadphase.setBounds(0, cube(Vector{0.0, 0.0, 0.0}, 1.0));
+    broadphase.setBounds(1, cube(Vector{2.0, 0.0, 0.0}, 1.0));
+    broadphase.setBounds(2, cube(Vector{2.0, 3.5, 0.0}, 1.0));
+    Pairs pairs;
+    broadphase.findOverlappingPairs(&pairs);
+    BOOST_CHECK(pairs == (Pairs{{0, 1}}));
+}
+
+BOOST_AUTO_TEST_CASE(invalid_bounds_are_unbounded)
+{
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    SweepAndPrune broadphase;
+    broadphase.resize(4);
+    broadphase.setBounds(0, cube(Vector{0.0, 0.0, 0.0}, 1.0));
+    broadphase.setBounds(1, cube(Vector{10.0, 0.0, 0.0}, 1.0));
+    broadphase.setBounds(2, cube(Vector{nan, 0.0, 0.0}, 1.0));
+    broadphase.setBounds(3, box(Vector{1.0, 0.0, 0.0}, Vector{-1.0, 0.0, 0.0}));
+    Pairs pairs;
+    broadphase.findOverlappingPairs(&pairs);
+    BOOST_CHECK(pairs == (Pairs{{0, 2}, {0, 3}, {1, 2}, {1, 3}, {2, 3}}));
+}
+
+// the result of the incremental sort has to match a brute force test while
+// the items move over many calls
+BOOST_AUTO_TEST_CASE(matches_brute_force)
+{
+    const size_t numItems = 60;
+    std::mt19937 random{42};
+    std::uniform_real_distribution<double> field{-20.0, 20.0};
+    std::uniform_real_distribution<double> step{-0.5, 0.5};
+    std::uniform_real_distribution<double> size{0.1, 3.0};
+
+    std::vector<Vector> centers;
+    std::vector<double> halfExtents;
+    for(size_t i = 0; i < numItems; ++i)
+    {
+        centers.emplace_back(field(random), field(random), field(random));
+        halfExtents.push_back(size(random));
+    }
+
+    SweepAndPrune broadphase;
+    broadphase.resize(numItems);
+    Pairs pairs;
+    for(int frame = 0; frame < 200; ++frame)
+    {
+        std::vector<WorldBounds> bounds;
+        for(size_t i = 0; i < numItems; ++i)
+        {
+            centers[i] += Vector{step(random), step(random), step(random)};
+            bounds.push_back(cube(centers[i], halfExtents[i]));
+            // a few items switch between bounded, unbounded and empty
+            if((i + frame) % 37 == 0)
+            {
+                bounds.back().bounded = false;
+            }
+            else if((i + frame) % 41 == 0)
+            {
+                bounds.back() = WorldBounds{};
+            }
+            broadphase.setBounds(i, bounds.back());
+        }
+
+        Pairs expected;
+        for(size_t l = 0; l < numItems; ++l)
+        {
+            for(size_t k = l + 1; k < numItems; ++k)
+            {
+                const auto &a = bounds[l];
+                const auto &b = bounds[k];
+                if((a.bounded && a.empty) || (b.bounded && b.empty))
+                {
+                    continue;
+                }
+                if(!a.bounded || !b.bounded || overlap(a, b))
+                {
+                    expected.emplace_back(l, k);
+                }
+            }
+        }
+
+        broadphase.findOverlappingPairs(&pairs);
+        BOOST_REQUIRE(pairs == expected);
+    }
+}
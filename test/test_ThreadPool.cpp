@@ -0,0 +1,69 @@
+/**
+ * \file test_ThreadPool.cpp
+ * \brief Tests of the work-stealing ThreadPool.
+ *
+ */
+
+#define BOOST_TEST_MODULE ThreadPool
+#include <boost/test/unit_test.hpp>
+
+#include <ThreadPool.hpp>
+
+#include <atomic>
+#include <vector>
+
+using mars::core::ThreadPool;
+
+BOOST_AUTO_TEST_CASE(every_index_runs_once)
+{
+    ThreadPool pool{4};
+    std::vector<std::atomic<int>> counts(1000);
+    pool.parallelFor(counts.size(), [&counts](size_t i) { ++counts[i]; });
+    for(auto &count: counts)
+    {
+        BOOST_CHECK_EQUAL(count.load(), 1);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(empty_and_single_jobs)
+{
+    ThreadPool pool{4};
+    int calls = 0;
+    pool.parallelFor(0, [&calls](size_t) { ++calls; });
+    BOOST_CHECK_EQUAL(calls, 0);
+    pool.parallelFor(1, [&calls](size_t) { ++calls; });
+    BOOST_CHECK_EQUAL(calls, 1);
+}
+
+BOOST_AUTO_TEST_CASE(nested_call_runs_serially)
+{
+    ThreadPool pool{4};
+    std::atomic<int> calls{0};
+    pool.parallelFor(8, [&pool, &calls](size_t)
+    {
+        pool.parallelFor(8, [&calls](size_t) { ++calls; });
+    });
+    BOOST_CHECK_EQUAL(calls.load(), 64);
+}
+
+// Back-to-back jobs with a fresh task object each time: a worker leaving
+// job N must never run an index of job N+1 with the task of job N, and
+// every job has to complete without deadlocking.
+BOOST_AUTO_TEST_CASE(back_to_back_jobs)
+{
+    ThreadPool pool{8};
+    for(size_t job = 0; job < 20000; ++job)
+    {
+        const size_t count = 1 + job % 13;
+        std::vector<std::atomic<size_t>> seen(count);
+        for(auto &s: seen)
+        {
+            s = 0;
+        }
+        pool.parallelFor(count, [&seen, job](size_t i) { seen[i] += job + 1; });
+        for(auto &s: seen)
+        {
+            BOOST_REQUIRE_EQUAL(s.load(), job + 1);
+        }
+    }
+}